@@ -0,0 +1,181 @@
+#include "batch_solver.h"
+
+#include <cmath>
+#include <stdexcept>
+
+BatchSolve::BatchSolve(std::vector<MainSolve*> cases)
+    : cases_(std::move(cases)) {
+  if (cases_.empty()) {
+    throw std::logic_error("Batch has no cases");
+  }
+  size_ = cases_.front()->GetMesh().Size();
+  const IniData::SolverSettings& settings =
+      cases_.front()->GetIniData().GetSolverSettings();
+  for (MainSolve* solver : cases_) {
+    const IniData::SolverSettings& other =
+        solver->GetIniData().GetSolverSettings();
+    if (solver->GetMesh().Size() != size_ ||
+        other.solve_time != settings.solve_time ||
+        other.solve_timestep != settings.solve_timestep) {
+      throw std::logic_error(
+          "Batch cases must share the mesh layout and time settings");
+    }
+  }
+  // Cases are stepped one after another, so the property updates of all of
+  // them run on the first one's pool instead of a pool per case.
+  for (MainSolve* solver : cases_) {
+    solver->GetMesh().SharePool(cases_.front()->GetMesh().SharedPool());
+  }
+  // Cases reading the same time schedule share the first one's samples.
+  for (MainSolve* solver : cases_) {
+    if (solver->Schedule() &&
+        &solver->GetIniData() == &cases_.front()->GetIniData()) {
+      solver->ShareSchedule(cases_.front()->Schedule());
+    }
+  }
+  A.resize(size_ * LANES);
+  B.resize(size_ * LANES);
+  C.resize(size_ * LANES);
+  F.resize(size_ * LANES);
+  alfa.resize(size_ * LANES);
+  beta.resize(size_ * LANES);
+  t_curr_.resize(size_ * LANES);
+}
+
+// Unused lanes replicate lane 0, so every lane works on finite numbers.
+void BatchSolve::LoadStep(const std::array<MainSolve*, LANES>& lanes) {
+  for (size_t l = 0; l < LANES; ++l) {
+    MainSolve* solver = lanes[l] ? lanes[l] : lanes.front();
+    std::span<const double> a = solver->CoefA();
+    std::span<const double> b = solver->CoefB();
+    std::span<const double> c = solver->CoefC();
+    std::span<const double> f = solver->CoefF();
+    std::span<const double> t = solver->GetMesh().TCurr();
+    for (size_t i = 0; i < size_; ++i) {
+      A[i * LANES + l] = a[i];
+      B[i * LANES + l] = b[i];
+      C[i * LANES + l] = c[i];
+      F[i * LANES + l] = f[i];
+      t_curr_[i * LANES + l] = t[i];
+    }
+  }
+}
+
+// Same arithmetic as MainSolve::IterateFused, run for all lanes at once. A
+// lane that has converged keeps its temperatures while the others iterate.
+void BatchSolve::SolveStep(const std::array<MainSolve*, LANES>& lanes) {
+  std::array<bool, LANES> active;
+  std::array<size_t, LANES> iters{};
+  std::array<IterNorms, LANES> norms{};
+  for (size_t l = 0; l < LANES; ++l) {
+    active[l] = lanes[l] != nullptr;
+  }
+  size_t n = size_ - 1;
+  bool running = true;
+  while (running) {
+    for (size_t l = 0; l < LANES; ++l) {
+      if (active[l]) {
+        SweepStart start = lanes[l]->LeftBoundary(t_curr_[l]);
+        alfa[l] = start.alfa;
+        beta[l] = start.beta;
+      }
+    }
+
+    for (size_t i = 1; i < n; ++i) {
+      const double* a = &A[i * LANES];
+      const double* b = &B[i * LANES];
+      const double* c = &C[i * LANES];
+      const double* f = &F[i * LANES];
+      const double* alfa_prev = &alfa[(i - 1) * LANES];
+      const double* beta_prev = &beta[(i - 1) * LANES];
+      double* alfa_i = &alfa[i * LANES];
+      double* beta_i = &beta[i * LANES];
+      for (size_t l = 0; l < LANES; ++l) {
+        double den = b[l] - c[l] * alfa_prev[l];
+        alfa_i[l] = a[l] / den;
+        beta_i[l] = (c[l] * beta_prev[l] - f[l]) / den;
+      }
+    }
+
+    std::array<double, LANES> max_change{};
+    std::array<double, LANES> max_abs{};
+    std::array<double, LANES> change_n{};
+    std::array<double, LANES> change_0{};
+    double* t_n = &t_curr_[n * LANES];
+    for (size_t l = 0; l < LANES; ++l) {
+      double t = t_n[l];
+      if (active[l]) {
+        t = lanes[l]->RightBoundary(t_n[l], alfa[(n - 1) * LANES + l],
+                                    beta[(n - 1) * LANES + l]);
+      }
+      change_n[l] = std::abs(t - t_n[l]);
+      max_change[l] = n > 0 ? change_n[l] : 0.0;
+      max_abs[l] = std::abs(t);
+      t_n[l] = t;
+    }
+
+    for (size_t i = n; i-- > 1;) {
+      const double* alfa_i = &alfa[i * LANES];
+      const double* beta_i = &beta[i * LANES];
+      const double* t_next = &t_curr_[(i + 1) * LANES];
+      double* t_i = &t_curr_[i * LANES];
+      for (size_t l = 0; l < LANES; ++l) {
+        double t = alfa_i[l] * t_next[l] + beta_i[l];
+        double change = std::abs(t - t_i[l]);
+        max_change[l] = max_change[l] < change ? change : max_change[l];
+        max_abs[l] = max_abs[l] < std::abs(t) ? std::abs(t) : max_abs[l];
+        t_i[l] = active[l] ? t : t_i[l];
+      }
+    }
+    if (n > 0) {
+      for (size_t l = 0; l < LANES; ++l) {
+        double t = alfa[l] * t_curr_[LANES + l] + beta[l];
+        change_0[l] = std::abs(t - t_curr_[l]);
+        max_abs[l] = max_abs[l] < std::abs(t) ? std::abs(t) : max_abs[l];
+        t_curr_[l] = active[l] ? t : t_curr_[l];
+      }
+    }
+
+    running = false;
+    for (size_t l = 0; l < LANES; ++l) {
+      if (!active[l]) {
+        continue;
+      }
+      ++iters[l];
+      norms[l] = {std::abs(max_change[l] / max_abs[l]), change_0[l],
+                  change_n[l]};
+      active[l] = norms[l].max >= EPS_ITER || norms[l].max_1 >= EPS_ITER ||
+                  norms[l].max_N >= EPS_ITER;
+      running = running || active[l];
+    }
+  }
+
+  for (size_t l = 0; l < LANES && lanes[l]; ++l) {
+    Mesh& mesh = lanes[l]->GetMesh();
+    mesh.TPrevIterUpdate();
+    std::span<double> t = mesh.TCurr();
+    for (size_t i = 0; i < size_; ++i) {
+      t[i] = t_curr_[i * LANES + l];
+    }
+    lanes[l]->LogIteration(iters[l], norms[l]);
+  }
+}
+
+void BatchSolve::solve_impl() {
+  for (size_t first = 0; first < cases_.size(); first += LANES) {
+    std::array<MainSolve*, LANES> lanes{};
+    for (size_t l = 0; l < LANES && first + l < cases_.size(); ++l) {
+      lanes[l] = cases_[first + l];
+    }
+    while (lanes.front()->Running()) {
+      for (size_t l = 0; l < LANES && lanes[l]; ++l) {
+        lanes[l]->BeginStep();
+      }
+      LoadStep(lanes);
+      SolveStep(lanes);
+      for (size_t l = 0; l < LANES && lanes[l]; ++l) {
+        lanes[l]->EndStep();
+      }
+    }
+  }
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <array>
+#include <vector>
+
+#include "solver.h"
+
+// Solves several cases that share one mesh layout and time settings in
+// lockstep. The tridiagonal sweep runs across cases: coefficients are stored
+// volume-major with LANES cases per volume, so the inner loops over lanes map
+// onto SIMD registers. Properties and boundary tables stay per case, except
+// that cases of one IniData read a single boundary time schedule.
+class BatchSolve {
+ public:
+#if defined(__AVX512F__)
+  static constexpr size_t LANES = 8;
+#else
+  static constexpr size_t LANES = 4;
+#endif
+
+ private:
+  std::vector<MainSolve*> cases_;
+  size_t size_;
+  std::vector<double> A;
+  std::vector<double> B;
+  std::vector<double> C;
+  std::vector<double> F;
+  std::vector<double> alfa;
+  std::vector<double> beta;
+  std::vector<double> t_curr_;
+
+  void LoadStep(const std::array<MainSolve*, LANES>& lanes);
+  void SolveStep(const std::array<MainSolve*, LANES>& lanes);
+
+ public:
+  BatchSolve(std::vector<MainSolve*> cases);
+  void solve_impl();
+};
@@ -2,31 +2,105 @@
 
 namespace heat_exchange {
 
-double HeatExchange::CalcAlphaAvd(IniDataAvd ini_data) const {
-  double ro = 1 / fuel_props_Tw_.at(fuel::FuelProp::v);
-  double mu = fuel_props_Tw_.at(fuel::FuelProp::mu);
-  double lt;
-  double cp;
-  if (ini_data.flow_type == flow::FlowType::subsonic) {
-    cp = fuel_props_Tw_.at(fuel::FuelProp::cp_eq);
-    lt = fuel_props_Tw_.at(fuel::FuelProp::lt_total);
+void HeatExchange::Stations::Resize(size_t n) {
+  for (std::vector<double>* v :
+       {&ro_w, &mu_w, &cp_w, &lt_w, &mu_s, &cp_s, &lt_s, &z_s, &u, &mach, &k,
+        &t_total, &t_static, &p_static, &s_ef, &r0}) {
+    v->resize(n);
+  }
+}
+
+flow::FlowParams HeatExchange::GetFlow(double p_total, double ksi,
+                                       flow::FlowType flow_type) {
+  for (const FlowEntry& entry : flow_cache_) {
+    if (entry.p_total == p_total && entry.ksi == ksi &&
+        entry.flow_type == flow_type) {
+      return entry.params;
+    }
+  }
+  FlowEntry entry{p_total, ksi, flow_type,
+                  flow_.GetParams(p_total, ksi, flow_type)};
+  ++flow_solves_;
+  if (flow_cache_.size() < FLOW_CACHE) {
+    flow_cache_.push_back(entry);
   } else {
-    cp = fuel_props_Tw_.at(fuel::FuelProp::cp_fr);
-    lt = fuel_props_Tw_.at(fuel::FuelProp::lt_gas);
+    flow_cache_[flow_next_] = entry;
+    flow_next_ = (flow_next_ + 1) % FLOW_CACHE;
+  }
+  return entry.params;
+}
+
+// Gas dynamics and property lookups run once per station; the correlations
+// then run in one branch-free loop over the gathered arrays. The subsonic
+// flow takes the equilibrium properties, the others the frozen ones.
+void HeatExchange::CalcAvd(std::span<const IniDataAvd> stations,
+                           std::span<Result> res) {
+  size_t n = stations.size();
+  Stations& st = stations_;
+  st.Resize(n);
+  for (size_t i = 0; i < n; ++i) {
+    const IniDataAvd& ini_data = stations[i];
+    flow::FlowParams flow_params =
+        GetFlow(ini_data.p_total, ini_data.r0 / ini_data.r_kr,
+                ini_data.flow_type);
+    fuel::PropValues props_w =
+        fuel_.GetProperties<fuel::FuelProp::v, fuel::FuelProp::mu,
+                            fuel::FuelProp::cp_eq, fuel::FuelProp::cp_fr,
+                            fuel::FuelProp::lt_total, fuel::FuelProp::lt_gas>(
+            flow_params.p_static, flow_params.t_total * 0.8);
+    fuel::PropValues props_s =
+        fuel_.GetProperties<fuel::FuelProp::mu, fuel::FuelProp::cp_eq,
+                            fuel::FuelProp::cp_fr, fuel::FuelProp::lt_total,
+                            fuel::FuelProp::lt_gas, fuel::FuelProp::z>(
+            flow_params.p_static, flow_params.t_static);
+    bool equilibrium = ini_data.flow_type == flow::FlowType::subsonic;
+    fuel::FuelProp cp = equilibrium ? fuel::FuelProp::cp_eq
+                                    : fuel::FuelProp::cp_fr;
+    fuel::FuelProp lt = equilibrium ? fuel::FuelProp::lt_total
+                                    : fuel::FuelProp::lt_gas;
+    st.ro_w[i] = 1 / props_w[fuel::FuelProp::v];
+    st.mu_w[i] = props_w[fuel::FuelProp::mu];
+    st.cp_w[i] = props_w[cp];
+    st.lt_w[i] = props_w[lt];
+    st.mu_s[i] = props_s[fuel::FuelProp::mu];
+    st.cp_s[i] = props_s[cp];
+    st.lt_s[i] = props_s[lt];
+    st.z_s[i] = props_s[fuel::FuelProp::z];
+    st.u[i] = flow_params.u;
+    st.mach[i] = flow_params.mach;
+    st.k[i] = flow_params.k;
+    st.t_total[i] = flow_params.t_total;
+    st.t_static[i] = flow_params.t_static;
+    st.p_static[i] = flow_params.p_static;
+    st.s_ef[i] = ini_data.s_ef;
+    st.r0[i] = ini_data.r0;
+  }
+
+  for (size_t i = 0; i < n; ++i) {
+    double pr_s = st.mu_s[i] * st.cp_s[i] / st.lt_s[i];
+    double te = st.t_static[i] * (1 + (st.k[i] - 1) / 2 * pow(pr_s, 1.0 / 3.0) *
+                                          pow(st.mach[i], 2));
+    double re = st.ro_w[i] * st.u[i] * st.s_ef[i] / st.mu_w[i];
+    double pr_w = st.mu_w[i] * st.cp_w[i] / st.lt_w[i];
+    double m = te / st.t_static[i];
+    res[i].alfa = 0.0296 * pow(re, -0.2) * pow(pr_w, -0.6) * st.ro_w[i] *
+                  st.cp_w[i] * st.u[i] *
+                  pow((0.9 * st.t_total[i] / te), 0.39) * pow(m, 0.11);
+    res[i].t_e = te;
+    res[i].t_rad = st.t_static[i];
+    res[i].eps_gas = 0.229 + 0.0616 * 5 + 0.00011 * st.t_static[i] -
+                     0.3684 * st.z_s[i] +
+                     0.00502 * st.p_static[i] / math::MEGA -
+                     0.00338 * st.r0[i] * 2.0;
   }
-  double Re = ro * flow_params_.u * ini_data.s_ef / mu;
-  double Pr = mu * cp / lt;
-  double Te = CalcTe(ini_data);
-  double m = Te / flow_params_.t_static;
-  double alpha = 0.0296 * pow(Re, -0.2) * pow(Pr, -0.6) * ro * cp *
-                 flow_params_.u * pow((0.9 * flow_params_.t_total / Te), 0.39) *
-                 pow(m, 0.11);
-  return alpha;
 }
 
 double HeatExchange::CalcAlphaCrit(double p, double t_w, double r0, double u,
                                    flow::FlowType flow_type) const {
-  fuel::PropValues fuel_props = fuel_.GetProperties(p, t_w);
+  fuel::PropValues fuel_props =
+      fuel_.GetProperties<fuel::FuelProp::v, fuel::FuelProp::mu,
+                          fuel::FuelProp::lt_total, fuel::FuelProp::cp_eq,
+                          fuel::FuelProp::cp_fr>(p, t_w);
   double ro = 1 / fuel_props.at(fuel::FuelProp::v);
   double mu = fuel_props.at(fuel::FuelProp::mu);
   double lt = fuel_props.at(fuel::FuelProp::lt_total);
@@ -41,36 +115,5 @@ double HeatExchange::CalcAlphaCrit(double p, double t_w, double r0, double u,
   double alpha = 0.023 * lt / r0 / 2.0 * pow(Re, 0.8) * pow(Pr, 0.3);
   return alpha;
 }
-double HeatExchange::CalcTe(IniDataAvd ini_data) const {
-  double mu = fuel_props_Tstatic_.at(fuel::FuelProp::mu);
-  double lt;
-  double cp;
-  double k = flow_params_.k;
-  if (ini_data.flow_type == flow::FlowType::subsonic) {
-    cp = fuel_props_Tstatic_.at(fuel::FuelProp::cp_eq);
-    lt = fuel_props_Tstatic_.at(fuel::FuelProp::lt_total);
-  } else {
-    cp = fuel_props_Tstatic_.at(fuel::FuelProp::cp_fr);
-    lt = fuel_props_Tstatic_.at(fuel::FuelProp::lt_gas);
-  }
-  double Pr = mu * cp / lt;
-  double m = 1 + (k - 1) / 2 * pow(Pr, 1.0 / 3.0) * pow(flow_params_.mach, 2);
-  double Te = flow_params_.t_static * m;
-  return Te;
-}
-double HeatExchange::CalcTRad(IniDataAvd ini_data) const {
-  return flow_
-      .GetParams(ini_data.p_total, ini_data.r0 / ini_data.r_kr,
-                 ini_data.flow_type)
-      .t_static;
-}
-double HeatExchange::CalcEmissitivity(IniDataAvd ini_data) const {
-  flow::FlowParams flow_params = flow_.GetParams(
-      ini_data.p_total, ini_data.r0 / ini_data.r_kr, ini_data.flow_type);
-  return 0.229 + 0.0616 * 5 + 0.00011 * flow_params.t_static -
-         0.3684 * fuel_props_Tstatic_.at(fuel::FuelProp::z) +
-         0.00502 * flow_params.p_static / math::MEGA -
-         0.00338 * ini_data.r0 * 2.0;
-}
 
 }  // namespace heat_exchange
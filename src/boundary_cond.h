@@ -1,5 +1,8 @@
 #pragma once
 
+#include <span>
+#include <vector>
+
 #include "fuel.h"
 #include "flow.h"
 #include "common.h"
@@ -38,14 +41,32 @@ class HeatExchange {
 private:
 	const fuel::Fuel &fuel_;
 	flow::Flow1D &flow_;
-	flow::FlowParams flow_params_;
-	fuel::PropValues fuel_props_Tw_;
-	fuel::PropValues fuel_props_Tstatic_;
-	double CalcAlphaAvd(IniDataAvd ini_data) const;
+	// Gas dynamics of the last FLOW_CACHE (p_total, r0 / r_kr, flow type)
+	// inputs, for repeats such as a pressure plateau or stations sharing one
+	// section. Entries are replaced in turn, so the cache never grows further.
+	static constexpr size_t FLOW_CACHE = 16;
+	struct FlowEntry {
+		double p_total;
+		double ksi;
+		flow::FlowType flow_type;
+		flow::FlowParams params;
+	};
+	std::vector<FlowEntry> flow_cache_;
+	size_t flow_next_ = 0;
+	size_t flow_solves_ = 0;
+	// Per-station inputs of the correlations, gathered so that the final loop
+	// runs over plain arrays. *_w are taken at the wall temperature, *_s at the
+	// static one.
+	struct Stations {
+		std::vector<double> ro_w, mu_w, cp_w, lt_w;
+		std::vector<double> mu_s, cp_s, lt_s, z_s;
+		std::vector<double> u, mach, k, t_total, t_static, p_static;
+		std::vector<double> s_ef, r0;
+		void Resize(size_t n);
+	};
+	Stations stations_;
+	flow::FlowParams GetFlow(double p_total, double ksi, flow::FlowType flow_type);
 	double CalcAlphaCrit(double p, double t_w, double r0, double u, flow::FlowType flow_type) const;
-	double CalcTe(IniDataAvd ini_data) const;
-	double CalcTRad(IniDataAvd ini_data) const;
-	double CalcEmissitivity(IniDataAvd ini_data) const;
 
 public:
 	HeatExchange(const fuel::Fuel &fuel, flow::Flow1D &flow) :
@@ -53,20 +74,17 @@ public:
 	}
 	template<typename T>
 	Result Calc(T ini_data, CalcType calc_type);
+	// Batch form of Calc(..., CalcType::avd): res[i] is the result for
+	// stations[i], a nozzle station or an instant of a firing history.
+	void CalcAvd(std::span<const IniDataAvd> stations, std::span<Result> res);
+	size_t FlowSolves() const { return flow_solves_; }
 };
 
 template<typename T>
 Result HeatExchange::Calc(T ini_data, CalcType calc_type) {
 	Result res;
 	if (calc_type == CalcType::avd) {
-		flow_params_ = flow_.GetParams(ini_data.p_total, ini_data.r0 / ini_data.r_kr,
-			ini_data.flow_type);
-		fuel_props_Tw_ = fuel_.GetProperties(flow_params_.p_static, flow_params_.t_total * 0.8);
-		fuel_props_Tstatic_ = fuel_.GetProperties(flow_params_.p_static, flow_params_.t_static);
-		res.alfa = CalcAlphaAvd(ini_data);
-		res.t_e = CalcTe(ini_data);
-		res.t_rad = CalcTRad(ini_data);
-		res.eps_gas = CalcEmissitivity(ini_data);
+		CalcAvd(std::span(&ini_data, 1), std::span(&res, 1));
 	}
 	return res;
 }
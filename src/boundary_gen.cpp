@@ -0,0 +1,209 @@
+#include "boundary_gen.h"
+
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+#include "boundary_cond.h"
+#include "mapped_file.h"
+#include "thread_pool.h"
+
+namespace heat_exchange {
+
+namespace {
+
+constexpr char CACHE_MAGIC[8] = {'1', 'D', 'H', 'B', 'N', 'D', '\0', '\0'};
+constexpr uint32_t CACHE_VERSION = 1;
+const size_t CHUNK = 512;
+
+// Cache file: the header, then time, alpha, te, trad and eps of each sample
+// as native doubles. The checksum covers everything after the header.
+struct CacheHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t reserved;
+  uint64_t key;
+  uint64_t count;
+  uint64_t checksum;
+};
+
+struct Sample {
+  double time;
+  double alpha;
+  double te;
+  double trad;
+  double eps;
+};
+
+uint64_t CacheKey(const IniData& ini, const fuel::Fuel& fuel) {
+  const IniData::Domain& domain = ini.GetDomainSettings();
+  const IniData::SolverSettings& settings = ini.GetSolverSettings();
+  std::vector<double> key{static_cast<double>(CACHE_VERSION),
+                          domain.throat_radius.value(),
+                          domain.initial_radius.value(),
+                          domain.blayer_length.value(),
+                          static_cast<double>(
+                              ini.GetBoundaryTable().flow_type),
+                          settings.solve_time,
+                          settings.solve_timestep};
+  for (const auto& [t, p] : ini.GetInitialState().pressure.value()) {
+    key.push_back(t);
+    key.push_back(p);
+  }
+  return Checksum(std::as_bytes(std::span(key))) ^
+         fuel.Fingerprint() * 1099511628211ULL;
+}
+
+bool LoadCache(const std::string& filename, uint64_t key,
+               std::vector<Sample>& samples) {
+  std::error_code ec;
+  if (!std::filesystem::exists(filename, ec)) {
+    return false;
+  }
+  try {
+    MappedFile file(filename);
+    std::span<const std::byte> bytes = file.Bytes();
+    CacheHeader header;
+    if (bytes.size() < sizeof(header)) {
+      return false;
+    }
+    std::memcpy(&header, bytes.data(), sizeof(header));
+    std::span<const std::byte> payload = bytes.subspan(sizeof(header));
+    if (std::memcmp(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0 ||
+        header.version != CACHE_VERSION || header.key != key ||
+        payload.size() != header.count * sizeof(Sample) ||
+        Checksum(payload) != header.checksum) {
+      return false;
+    }
+    samples.resize(header.count);
+    std::memcpy(samples.data(), payload.data(), payload.size());
+  } catch (const std::runtime_error&) {
+    return false;
+  }
+  return true;
+}
+
+// Written to a temporary file and renamed, as the material cache; the name is
+// unique per thread since stations may generate tables concurrently.
+void WriteCache(const std::string& filename, uint64_t key,
+                const std::vector<Sample>& samples) {
+  std::span<const std::byte> payload = std::as_bytes(std::span(samples));
+  CacheHeader header{};
+  std::memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+  header.version = CACHE_VERSION;
+  header.key = key;
+  header.count = samples.size();
+  header.checksum = Checksum(payload);
+  std::string tmp =
+      filename + "." + std::to_string(getpid()) + "." +
+      std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id()));
+  {
+    std::ofstream out(tmp, std::ios::binary);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(payload.data()), payload.size());
+    if (!out) {
+      out.close();
+      std::remove(tmp.c_str());
+      return;
+    }
+  }
+  std::error_code ec;
+  std::filesystem::rename(tmp, filename, ec);
+  if (ec) {
+    std::remove(tmp.c_str());
+  }
+}
+
+// Samples at n * solve_timestep, n = 0..steps, with the step count of
+// BoundarySchedule.
+std::vector<Sample> Compute(const IniData& ini, const fuel::Fuel& fuel) {
+  const IniData::Domain& domain = ini.GetDomainSettings();
+  const IniData::SolverSettings& settings = ini.GetSolverSettings();
+  const std::map<double, double>& pressure =
+      ini.GetInitialState().pressure.value();
+  size_t steps = 0;
+  for (double time = 0.0; settings.solve_time - time > EPS;
+       time += settings.solve_timestep) {
+    ++steps;
+  }
+  std::vector<IniDataAvd> stations(steps + 1);
+  std::vector<Sample> samples(steps + 1);
+  math::Cursor<double, double> cursor;
+  for (size_t n = 0; n <= steps; ++n) {
+    samples[n].time = n * settings.solve_timestep;
+    stations[n] = {math::Linterp(pressure, samples[n].time, cursor),
+                   domain.throat_radius.value(), domain.initial_radius.value(),
+                   domain.blayer_length.value(),
+                   ini.GetBoundaryTable().flow_type};
+  }
+
+  flow::Flow1D flow(fuel, true);
+  size_t threads = settings.threads;
+  if (threads == 0) {
+    threads = std::thread::hardware_concurrency();
+  }
+  ThreadPool pool(threads);
+  size_t chunks = (stations.size() + CHUNK - 1) / CHUNK;
+  pool.ParallelFor(chunks, [&](size_t c) {
+    size_t first = c * CHUNK;
+    size_t count = std::min(CHUNK, stations.size() - first);
+    HeatExchange exchange(fuel, flow);
+    std::vector<Result> res(count);
+    exchange.CalcAvd(std::span(stations).subspan(first, count), res);
+    for (size_t k = 0; k < count; ++k) {
+      Sample& sample = samples[first + k];
+      sample.alpha = res[k].alfa;
+      sample.te = res[k].t_e;
+      sample.trad = res[k].t_rad;
+      sample.eps = res[k].eps_gas;
+    }
+  });
+  return samples;
+}
+
+}  // namespace
+
+IniData::HeatTransfer GenerateHeatLeft(const IniData& ini,
+                                       const fuel::Fuel& fuel,
+                                       const std::string& cache_dir) {
+  const IniData::Domain& domain = ini.GetDomainSettings();
+  if (!ini.GetInitialState().pressure || !domain.throat_radius ||
+      !domain.initial_radius || !domain.blayer_length) {
+    throw std::logic_error(
+        "Boundary generation needs pressure, throat radius, initial radius "
+        "and blayer length");
+  }
+  uint64_t key = CacheKey(ini, fuel);
+  std::stringstream name;
+  name << cache_dir << '/' << std::hex << key << ".bin";
+  std::vector<Sample> samples;
+  if (!LoadCache(name.str(), key, samples)) {
+    samples = Compute(ini, fuel);
+    std::error_code ec;
+    std::filesystem::create_directories(cache_dir, ec);
+    WriteCache(name.str(), key, samples);
+  }
+
+  IniData::HeatTransfer heat;
+  for (const Sample& sample : samples) {
+    heat.alpha.emplace_hint(heat.alpha.end(), sample.time, sample.alpha);
+    heat.te.emplace_hint(heat.te.end(), sample.time, sample.te);
+    heat.trad.emplace_hint(heat.trad.end(), sample.time, sample.trad);
+    heat.eps.emplace_hint(heat.eps.end(), sample.time, sample.eps);
+  }
+  heat.q = ini.GetBoundaryTable().heat_left.q;
+  return heat;
+}
+
+void PrepareBoundary(IniData& ini, const fuel::Fuel& fuel) {
+  if (ini.GetSolverSettings().generate_boundary) {
+    ini.SetHeatLeft(GenerateHeatLeft(ini, fuel));
+  }
+}
+
+}  // namespace heat_exchange
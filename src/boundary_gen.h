@@ -0,0 +1,24 @@
+#pragma once
+#include <string>
+
+#include "fuel.h"
+#include "ini_data.h"
+
+namespace heat_exchange {
+
+// Builds the gas-side (left) boundary tables from the chamber pressure
+// history. At every solver time step the pressure drives Flow1D and
+// HeatExchange at the station r0 = initial radius of a nozzle with the given
+// throat radius, with the blayer length as the effective length. The tables
+// are indexed by time; q is kept from the ini tables. Time chunks run in
+// parallel. The samples are cached in cache_dir under a hash of every input,
+// so a repeated run only maps the file.
+IniData::HeatTransfer GenerateHeatLeft(const IniData& ini,
+                                       const fuel::Fuel& fuel,
+                                       const std::string& cache_dir =
+                                           "boundaries");
+
+// Replaces the left tables with generated ones if the ini asks for it.
+void PrepareBoundary(IniData& ini, const fuel::Fuel& fuel);
+
+}  // namespace heat_exchange
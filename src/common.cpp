@@ -66,8 +66,12 @@ std::string FileName(const std::string &name, char entry_type) {
   std::string filename;
   if (entry_type == 'f') {
     filename = "fuels/" + name + ".json";
+  } else if (entry_type == 'F') {
+    filename = "fuels/" + name + ".bin";
   } else if (entry_type == 'm') {
     filename = "materials/" + name + ".json";
+  } else if (entry_type == 'M') {
+    filename = "materials/" + name + ".bin";
   }
   return filename;
 }
@@ -103,4 +107,11 @@ double math::Linterp(const std::map<double, double> &c, double p) {
   auto bounds = math::GetParamBounds(c, p);
   return math::Linterp(bounds.first->first, bounds.second->first,
                        bounds.first->second, bounds.second->second, p);
+}
+
+double math::Linterp(const std::map<double, double> &c, double p,
+                     Cursor<double, double> &cursor) {
+  auto bounds = cursor.Bounds(c, p);
+  return math::Linterp(bounds.first->first, bounds.second->first,
+                       bounds.first->second, bounds.second->second, p);
 }
\ No newline at end of file
@@ -1,9 +1,11 @@
 #pragma once
+#include <algorithm>
 #include <cmath>
 #include <fstream>
 #include <functional>
 #include <map>
 #include <optional>
+#include <span>
 #include <string>
 #include <vector>
 
@@ -52,6 +54,112 @@ auto GetParamBounds(const std::map<T1, T2> &c, T1 t) {
   return std::make_pair(it1, it2);
 }
 
+// Lookup statistics of a cursor: a hit is a call answered from the
+// remembered interval or one of its neighbours.
+class CursorStats {
+ protected:
+  size_t calls_ = 0;
+  size_t hits_ = 0;
+
+ public:
+  size_t Calls() const { return calls_; }
+  size_t Hits() const { return hits_; }
+  double HitRate() const {
+    return calls_ == 0 ? 0.0 : static_cast<double>(hits_) / calls_;
+  }
+};
+
+// Stateful form of GetParamBounds for arguments that change slowly between
+// calls: the upper bound of the last lookup is checked, then its neighbours,
+// before falling back to upper_bound. The bounds are the same as from
+// GetParamBounds. A cursor follows one map and restarts on another one.
+template <typename T1, typename T2>
+class Cursor : public CursorStats {
+ public:
+  using Iterator = typename std::map<T1, T2>::const_iterator;
+
+  std::pair<Iterator, Iterator> Bounds(const std::map<T1, T2> &c, T1 t) {
+    if (c.size() == 1) {
+      return std::make_pair(c.begin(), c.begin());
+    }
+    ++calls_;
+    if (map_ == &c && Find(c, t)) {
+      ++hits_;
+    } else {
+      map_ = &c;
+      upper_ = c.upper_bound(t);
+      lower_ = upper_ == c.begin() ? upper_ : std::prev(upper_);
+    }
+    if (upper_ == c.end()) {
+      return std::make_pair(lower_, lower_);
+    }
+    return std::make_pair(lower_, upper_);
+  }
+
+ private:
+  const std::map<T1, T2> *map_ = nullptr;
+  // upper_bound of the last argument and its predecessor, or begin.
+  Iterator upper_;
+  Iterator lower_;
+
+  bool Find(const std::map<T1, T2> &c, T1 t) {
+    bool above_lower = upper_ == c.begin() || !(t < lower_->first);
+    bool below_upper = upper_ == c.end() || t < upper_->first;
+    if (above_lower && below_upper) {
+      return true;
+    }
+    if (above_lower) {
+      Iterator next = std::next(upper_);
+      if (next == c.end() || t < next->first) {
+        lower_ = upper_;
+        upper_ = next;
+        return true;
+      }
+    } else if (lower_ == c.begin() || !(t < std::prev(lower_)->first)) {
+      upper_ = lower_;
+      lower_ = lower_ == c.begin() ? lower_ : std::prev(lower_);
+      return true;
+    }
+    return false;
+  }
+};
+
+// Cursor over a sorted knot array: Segment returns the largest k in
+// [0, size - 2] with knots[k] <= t, or 0, as a binary search would.
+class SegmentCursor : public CursorStats {
+ private:
+  size_t k_ = 0;
+
+ public:
+  size_t Segment(std::span<const double> knots, double t) {
+    ++calls_;
+    size_t last = knots.size() - 2;
+    auto holds = [&](size_t k) {
+      return (k == 0 || knots[k] <= t) && (k == last || t < knots[k + 1]);
+    };
+    if (k_ <= last) {
+      if (holds(k_)) {
+        ++hits_;
+        return k_;
+      }
+      if (k_ < last && holds(k_ + 1)) {
+        ++hits_;
+        return ++k_;
+      }
+      if (k_ > 0 && holds(k_ - 1)) {
+        ++hits_;
+        return --k_;
+      }
+    }
+    auto it = std::upper_bound(knots.begin() + 1, knots.end() - 1, t);
+    k_ = static_cast<size_t>(it - knots.begin()) - 1;
+    return k_;
+  }
+};
+
+double Linterp(const std::map<double, double> &c, double p,
+               Cursor<double, double> &cursor);
+
 template <typename Func>
 double Integral(double a, double b, Func fx) {
   double dx = (b - a) / N_INTEGRATION;
@@ -1,5 +1,7 @@
 #include "data_base.h"
 
+#include <set>
+
 #include "ini_data.h"
 
 using json = nlohmann::json;
@@ -7,13 +9,74 @@ using ordered_json = nlohmann::ordered_json;
 
 namespace base {
 
-Database::Database(const std::string &name) : ini_data_(name) {
-  const IniData::Domain &domain = ini_data_.GetDomainSettings();
+Registry &Registry::Instance() {
+  static Registry registry;
+  return registry;
+}
+
+// A failed load is dropped from the map after its waiters get the exception,
+// so the next call tries again.
+template <typename Key, typename Value, typename Load>
+std::shared_ptr<const Value> Registry::Find(Entries<Key, Value> &entries,
+                                            const Key &key, Load load) {
+  std::promise<std::shared_ptr<const Value>> promise;
+  std::shared_future<std::shared_ptr<const Value>> entry;
+  bool first = false;
+  {
+    std::lock_guard lock(mutex_);
+    auto [it, inserted] = entries.try_emplace(key);
+    if (inserted) {
+      it->second = promise.get_future().share();
+      first = true;
+    }
+    entry = it->second;
+  }
+  if (first) {
+    try {
+      promise.set_value(load());
+    } catch (...) {
+      {
+        std::lock_guard lock(mutex_);
+        entries.erase(key);
+      }
+      promise.set_exception(std::current_exception());
+    }
+  }
+  return entry.get();
+}
+
+std::shared_ptr<const material::Material> Registry::GetMaterial(
+    const std::string &name, double angle, double grid_step) {
+  return Find(materials_, MaterialKey{name, angle, grid_step}, [&] {
+    return std::make_shared<const material::Material>(name, angle, grid_step);
+  });
+}
+
+std::shared_ptr<const fuel::Fuel> Registry::GetFuel(const std::string &name) {
+  return Find(fuels_, name,
+              [&] { return std::make_shared<const fuel::Fuel>(name); });
+}
+
+Database::Database(const std::string &name) : Database(IniData(name)) {}
+
+Database::Database(const IniData &ini_data) { Add(ini_data); }
+
+void Database::Add(const IniData &ini_data) {
+  const IniData::Domain &domain = ini_data.GetDomainSettings();
+  double grid_step = ini_data.GetSolverSettings().material_grid_step;
+  Registry &registry = Registry::Instance();
   for (size_t i = 0; i < domain.mat_names.size(); ++i) {
-    material::Material mat(domain.mat_names[i], domain.angles[i]);
-    materials_.emplace(domain.mat_names[i], mat);
+    auto &mat = materials_[{domain.mat_names[i], domain.angles[i], grid_step}];
+    if (mat) {
+      continue;
+    }
+    mat = registry.GetMaterial(domain.mat_names[i], domain.angles[i],
+                               grid_step);
+  }
+  auto &fuel = fuels_[domain.fuel_name];
+  if (!fuel) {
+    fuel = registry.GetFuel(domain.fuel_name);
   }
-  fuel_ = std::make_unique<fuel::Fuel>(domain.fuel_name);
 }
 
 void Database::OpenEntry(const std::string &name, char entry_type) {
@@ -161,22 +224,36 @@ void Database::AddFuel(const std::string &fuel_name,
   }
   std::ofstream fout("fuels/" + fuel_name + ".json");
   fout << res.dump(4);
+  fout.close();
+  // Compiled copy of the entry that cases map instead of parsing the JSON.
+  std::ifstream fin("fuels/" + fuel_name + ".json");
+  fuel::Fuel(fin).WriteBinary(FileName(fuel_name, 'F'));
 }
 
 const fuel::Fuel &Database::GetFuel(const std::string &fuel_name) const {
-  return *fuel_;
+  return *fuels_.at(fuel_name);
+}
+
+const material::Material &Database::GetMaterial(const std::string &mat_name,
+                                               double angle,
+                                               double grid_step) const {
+  return *materials_.at({mat_name, angle, grid_step});
 }
 
 const material::Material &Database::GetMaterial(
     const std::string &mat_name) const {
-  return materials_.at(mat_name);
+  auto it = materials_.lower_bound({mat_name, -HUGE_VAL, -HUGE_VAL});
+  if (it == materials_.end() || std::get<0>(it->first) != mat_name) {
+    throw std::out_of_range("Material " + mat_name + " is not loaded");
+  }
+  return *it->second;
 }
 
 void Database::PrintFuel(const std::string &fuel_name, std::ostream &os) const {
-  fuel::Fuel fuel = GetFuel(fuel_name);
+  const fuel::Fuel &fuel = GetFuel(fuel_name);
   os.setf(std::ios_base::left);
   os << std::setw(8) << "P, MPa" << std::setw(7) << "T, K" << std::endl;
-  for (const auto [press, temp] : fuel.GetTotalTemperatures()) {
+  for (const auto &[press, temp] : fuel.GetTotalTemperatures()) {
     os.precision(1);
     os << std::setw(8) << std::fixed << press / 1000000 << std::setw(7) << temp
        << std::endl;
@@ -186,14 +263,15 @@ void Database::PrintFuel(const std::string &fuel_name, std::ostream &os) const {
     os << std::setw(18) << name;
   }
   os << std::endl;
-  for (const auto &[press, properties] : fuel.GetProperties()) {
-    for (const auto &[temp, props] : properties) {
+  for (double press : fuel.PressureKnots()) {
+    for (double temp : fuel.TemperatureKnots()) {
+      fuel::PropValues props = fuel.GetProperties(press, temp);
       os.precision(1);
       os << std::fixed << std::setw(18) << press / 1000000 << std::setw(18)
          << temp;
       os.precision(4);
-      for (const auto &[type, prop] : props) {
-        os << std::setw(18) << std::scientific << prop;
+      for (int i = fuel::FuelProp::v; i < fuel::FuelProp::null; ++i) {
+        os << std::setw(18) << std::scientific << props[i];
       }
       os << std::endl;
     }
@@ -242,4 +320,17 @@ void Database::PrintMat(const std::string &mat_name, std::ostream &os) const {
   }
 }
 
+void Database::PrintGridReport(std::ostream &os,
+                               const IniData &ini_data) const {
+  const IniData::Domain &domain = ini_data.GetDomainSettings();
+  double grid_step = ini_data.GetSolverSettings().material_grid_step;
+  std::set<std::pair<std::string, double>> printed;
+  for (size_t i = 0; i < domain.mat_names.size(); ++i) {
+    if (printed.emplace(domain.mat_names[i], domain.angles[i]).second) {
+      GetMaterial(domain.mat_names[i], domain.angles[i], grid_step)
+          .PrintGridReport(os);
+    }
+  }
+}
+
 }  // namespace base
@@ -1,9 +1,13 @@
 
 #pragma once
+#include <future>
 #include <iostream>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <nlohmann/json.hpp>
 #include <string>
+#include <tuple>
 
 #include "common.h"
 #include "fuel.h"
@@ -14,11 +18,42 @@ namespace base {
 
 enum class FileContent { fuel_total_temp, fuel_props, mat_props };
 
+// Process-wide store of loaded tables. Every entry is loaded once, never
+// changed afterwards and kept for the life of the process, so any number of
+// databases and solvers on any thread can read it without copies. The lock
+// covers only the maps: an entry is a future that its first caller fulfils,
+// so different tables load in parallel and later callers of one wait for it.
+class Registry {
+ private:
+  using MaterialKey = std::tuple<std::string, double, double>;
+  template <typename Key, typename Value>
+  using Entries =
+      std::map<Key, std::shared_future<std::shared_ptr<const Value>>>;
+  std::mutex mutex_;
+  Entries<MaterialKey, material::Material> materials_;
+  Entries<std::string, fuel::Fuel> fuels_;
+
+  Registry() = default;
+  template <typename Key, typename Value, typename Load>
+  std::shared_ptr<const Value> Find(Entries<Key, Value> &entries,
+                                    const Key &key, Load load);
+
+ public:
+  static Registry &Instance();
+  std::shared_ptr<const material::Material> GetMaterial(
+      const std::string &name, double angle, double grid_step);
+  std::shared_ptr<const fuel::Fuel> GetFuel(const std::string &name);
+};
+
+// Tables of one case, borrowed from the Registry. A material used at several
+// fiber angles or grid steps has an entry per angle and step, as cases added
+// later may resample it differently.
 class Database {
  private:
-  std::map<std::string, material::Material> materials_;
-  std::unique_ptr<fuel::Fuel> fuel_;
-  IniData ini_data_;
+  std::map<std::tuple<std::string, double, double>,
+           std::shared_ptr<const material::Material>>
+      materials_;
+  std::map<std::string, std::shared_ptr<const fuel::Fuel>> fuels_;
 
   nlohmann::json ReadPropsCSV(const std::string &file_name,
                               FileContent file_content) const;
@@ -36,6 +71,9 @@ class Database {
  public:
   Database() = default;
   Database(const std::string& name);
+  Database(const IniData& ini_data);
+  // Borrows the tables of one more case, e.g. another station of a nozzle.
+  void Add(const IniData& ini_data);
   void OpenEntry(const std::string &name, char entry_type);
   void AddFuel(const std::string &fuel_name,
                const std::vector<std::string> &file_names);
@@ -45,10 +83,16 @@ class Database {
   void CreateEntryTemplate(const std::string &name, char entry_type) const;
 
   const fuel::Fuel& GetFuel(const std::string &fuel_name) const;
+  const material::Material& GetMaterial(const std::string &mat_name,
+                                        double angle, double grid_step) const;
+  // Any loaded angle of the material, for listings.
   const material::Material& GetMaterial(const std::string &mat_name) const;
 
   void PrintFuel(const std::string &fuel_name, std::ostream &os) const;
   void PrintMat(const std::string &mat_name, std::ostream &os) const;
+  // Resampling errors of the grids of the case's materials, each material and
+  // angle once; builds the grids if no lookup has yet.
+  void PrintGridReport(std::ostream &os, const IniData &ini_data) const;
 };
 
 }  // namespace base
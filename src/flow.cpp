@@ -1,27 +1,119 @@
+#include <algorithm>
 #include <iostream>
 #include "flow.h"
 
 namespace flow {
 
-void Flow1D::CalcLambda(FlowParams &flow_params, FlowType flow_type) const {
-	double n = 1 / (flow_params.k - 1.0);
-	double k1 = flow_params.k + 1.0;
-	double k2 = flow_params.k - 1.0;
-	double prev_value;
-	do {
-		prev_value = flow_params.lambda;
-		if (flow_type == FlowType::subsonic) {
-			flow_params.lambda = 1.0
-					/ (pow(k1 / 2.0, n) * pow(1.0 - prev_value * prev_value * k2 / k1, n) * flow_params.ksi
-							* flow_params.ksi);
-		} else if (flow_type == FlowType::supersonic) {
-			flow_params.lambda = k1 / k2 / prev_value
-					- 2 / pow(prev_value, flow_params.k) / k2 / pow(flow_params.ksi, 2 * flow_params.k - 2);
+double SolveLambda(double ksi, double k, FlowType flow_type, double guess,
+		int *iters) {
+	if (iters) {
+		*iters = 0;
+	}
+	if (flow_type == FlowType::sonic || !(ksi > 1.0)) {
+		return 1.0;
+	}
+	double a = (k - 1.0) / (k + 1.0);
+	double n = 1.0 / (k - 1.0);
+	double target = n * std::log((k + 1.0) / 2.0) + 2.0 * std::log(ksi);
+	bool subsonic = flow_type == FlowType::subsonic;
+	double lo = subsonic ? 0.0 : 1.0;
+	double hi = subsonic ? 1.0 : std::sqrt(1.0 / a);
+	double lambda = guess > lo && guess < hi ? guess : 0.5 * (lo + hi);
+	// g = ln q(lambda) + 2 ln ksi rises on the subsonic branch and falls on
+	// the supersonic one.
+	for (int i = 1; i <= 100; ++i) {
+		double e = 1.0 - a * lambda * lambda;
+		double g = std::log(lambda) + n * std::log(e) + target;
+		if ((g < 0.0) == subsonic) {
+			lo = lambda;
 		} else {
-			flow_params.lambda = 1.0;
-			return;
+			hi = lambda;
+		}
+		double g1 = 1.0 / lambda - 2.0 * n * a * lambda / e;
+		double g2 = -1.0 / (lambda * lambda)
+				- 2.0 * n * a * (1.0 + a * lambda * lambda) / (e * e);
+		double step = 2.0 * g * g1 / (2.0 * g1 * g1 - g * g2);
+		if (std::abs(step) <= 1E-12 * lambda) {
+			lambda -= step;
+			if (iters) {
+				*iters = i;
+			}
+			break;
+		}
+		lambda -= step;
+		if (!(lambda > lo && lambda < hi)) {
+			lambda = 0.5 * (lo + hi);
+		}
+	}
+	return lambda;
+}
+
+LambdaTable::LambdaTable(double k_min, double k_max) :
+		k_min_(k_min), k_step_((k_max - k_min) / (K_NODES - 1)), subsonic_(
+				K_NODES * S_NODES), supersonic_(K_NODES * S_NODES) {
+	for (size_t i = 0; i < K_NODES; ++i) {
+		double k = k_min_ + i * k_step_;
+		for (size_t j = 0; j < S_NODES; ++j) {
+			double s = static_cast<double>(j) / (S_NODES - 1);
+			size_t node = i * S_NODES + j;
+			if (j == 0) {
+				subsonic_[node] = supersonic_[node] = 1.0;
+			} else if (j + 1 == S_NODES) {
+				subsonic_[node] = 0.0;
+				supersonic_[node] = std::sqrt((k + 1.0) / (k - 1.0));
+			} else {
+				subsonic_[node] = SolveLambda(1.0 / std::sqrt(1.0 - s * s), k,
+						FlowType::subsonic);
+				supersonic_[node] = SolveLambda(
+						std::pow(1.0 - s * s, -0.5 / (k - 1.0)), k,
+						FlowType::supersonic);
+			}
+		}
+	}
+}
+
+double LambdaTable::Guess(double ksi, double k, FlowType flow_type) const {
+	if (flow_type == FlowType::sonic || !(ksi > 1.0)) {
+		return 1.0;
+	}
+	const std::vector<double> &table =
+			flow_type == FlowType::subsonic ? subsonic_ : supersonic_;
+	double q = flow_type == FlowType::subsonic ?
+			1.0 / (ksi * ksi) : std::pow(ksi, 2.0 - 2.0 * k);
+	double u = std::sqrt(1.0 - q) * (S_NODES - 1);
+	size_t j = std::min(static_cast<size_t>(u), S_NODES - 2);
+	double ws = u - j;
+	double v = k_step_ > 0.0 ? (k - k_min_) / k_step_ : 0.0;
+	v = std::clamp(v, 0.0, static_cast<double>(K_NODES - 1));
+	size_t i = std::min(static_cast<size_t>(v), K_NODES - 2);
+	double wk = v - i;
+	const double *row = &table[i * S_NODES + j];
+	double lower = row[0] + (row[1] - row[0]) * ws;
+	double upper = row[S_NODES] + (row[S_NODES + 1] - row[S_NODES]) * ws;
+	return lower + (upper - lower) * wk;
+}
+
+Flow1D::Flow1D(const fuel::Fuel &fuel, bool lambda_table) :
+		fuel_(fuel) {
+	if (lambda_table) {
+		double k_min = HUGE_VAL;
+		double k_max = -HUGE_VAL;
+		for (double p : fuel_.PressureKnots()) {
+			for (double t : fuel_.TemperatureKnots()) {
+				double k = fuel_.GetProperty(p, t, fuel::FuelProp::k_eq);
+				k_min = std::min(k_min, k);
+				k_max = std::max(k_max, k);
+			}
 		}
-	} while (std::abs(flow_params.lambda - prev_value) > 0.00001);
+		lambda_table_.emplace(k_min, k_max);
+	}
+}
+
+void Flow1D::CalcLambda(FlowParams &flow_params, FlowType flow_type) const {
+	double guess = lambda_table_ ?
+			lambda_table_->Guess(flow_params.ksi, flow_params.k, flow_type) : 0.0;
+	flow_params.lambda = SolveLambda(flow_params.ksi, flow_params.k, flow_type,
+			guess);
 }
 
 void Flow1D::CalcPressStatic(FlowParams &flow_params) const {
@@ -40,9 +132,9 @@ void Flow1D::CalcTempStatic(FlowParams &flow_params) const {
 }
 
 void Flow1D::CalcVelocity(FlowParams &flow_params) const {
-	auto fuel_props_static = fuel_.GetProperties(flow_params.p_static, flow_params.t_static);
-	double a = pow(flow_params.k * flow_params.p_static * fuel_props_static.at(fuel::FuelProp::v),
-			0.5);
+	double v_static = fuel_.GetProperty(flow_params.p_static, flow_params.t_static,
+			fuel::FuelProp::v);
+	double a = pow(flow_params.k * flow_params.p_static * v_static, 0.5);
 	flow_params.mach = flow_params.lambda * pow(2 / (flow_params.k + 1), 0.5)
 			/ pow(
 					1
@@ -57,7 +149,7 @@ FlowParams Flow1D::GetParams(double p_total, double ksi, FlowType flow_type) con
 	res.p_total = p_total;
 	res.ksi = ksi;
 	res.t_total = fuel_.GetTotalTemp(p_total);
-	res.k = fuel_.GetProperties(res.p_total, res.t_total).at(fuel::FuelProp::k_eq);
+	res.k = fuel_.GetProperty(res.p_total, res.t_total, fuel::FuelProp::k_eq);
 	CalcLambda(res, flow_type);
 	CalcPressStatic(res);
 	CalcTempStatic(res);
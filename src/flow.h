@@ -1,6 +1,8 @@
 #ifndef FLOW_H_
 #define FLOW_H_
 #include <cmath>
+#include <optional>
+#include <vector>
 #include "fuel.h"
 
 namespace flow {
@@ -21,6 +23,33 @@ struct FlowParams {
 	double ksi;
 };
 
+// Velocity coefficient on the subsonic or supersonic branch for the radius
+// ratio ksi, i.e. the root of q(lambda) = 1 / ksi^2. Halley iterations on
+// ln q with analytic derivatives, kept inside the branch by bisection;
+// guess <= 0 starts from a rough estimate. iters, if given, receives the
+// number of iterations.
+double SolveLambda(double ksi, double k, FlowType flow_type, double guess = 0.0,
+		int *iters = nullptr);
+
+// Roots of both branches tabulated over s and k, for starting points close
+// enough that SolveLambda converges in one or two steps. s = sqrt(1 - q) on
+// the subsonic branch and sqrt(1 - q^(k-1)) on the supersonic one, q = 1/ksi^2;
+// lambda is smooth in s on both, including at the sonic point and as the
+// supersonic branch approaches its limit.
+class LambdaTable {
+private:
+	static const size_t S_NODES = 65;
+	static const size_t K_NODES = 17;
+	double k_min_;
+	double k_step_;
+	std::vector<double> subsonic_;
+	std::vector<double> supersonic_;
+
+public:
+	LambdaTable(double k_min, double k_max);
+	double Guess(double ksi, double k, FlowType flow_type) const;
+};
+
 class Flow1D {
 private:
 	double Lambda(double prev_value, FlowType flow_type) const;
@@ -30,10 +59,11 @@ private:
 	void CalcVelocity(FlowParams& flow_params) const;
 
 	const fuel::Fuel &fuel_;
+	std::optional<LambdaTable> lambda_table_;
 
 public:
-	Flow1D(const fuel::Fuel &fuel) :
-			fuel_(fuel) {}
+	// With lambda_table the table is built over the range of k_eq in the fuel.
+	Flow1D(const fuel::Fuel &fuel, bool lambda_table = false);
 	FlowParams GetParams(double p_total, double ksi, FlowType flow_type) const;
 };
 
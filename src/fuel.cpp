@@ -1,15 +1,59 @@
 #include "fuel.h"
 
+#include <unistd.h>
+
+#include <algorithm>
 #include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <set>
+#include <stdexcept>
 
 #include "common.h"
+#include "mapped_file.h"
 
 namespace fuel {
 
-Fuel::Fuel(const std::string& name) {
-  std::string str = FileName(name, 'f');
-  std::ifstream fin(str);
-  Initialize(fin);
+namespace {
+
+constexpr char BINARY_MAGIC[8] = {'1', 'D', 'H', 'F', 'U', 'E', 'L', '\0'};
+constexpr uint32_t BINARY_VERSION = 1;
+
+// Binary fuel file: the header, then the total temperature pressures and
+// values, the pressure knots, the temperature knots and the [p][T][prop] grid,
+// all as native doubles. The checksum covers everything after the header.
+struct BinaryHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t props;
+  uint64_t total_temp;
+  uint64_t p_knots;
+  uint64_t t_knots;
+  uint64_t checksum;
+};
+
+}  // namespace
+
+Fuel::Fuel(const std::string& name)
+    : Fuel(Load(FileName(name, 'f'), FileName(name, 'F'))) {}
+
+// The binary file is used unless the JSON entry was edited after it. A stale,
+// corrupted or older-version file is rebuilt from the JSON.
+Fuel Fuel::Load(const std::string& json, const std::string& bin) {
+  std::error_code ec;
+  auto bin_time = std::filesystem::last_write_time(bin, ec);
+  if (!ec && !(bin_time < std::filesystem::last_write_time(json, ec))) {
+    try {
+      return FromBinary(bin);
+    } catch (const std::runtime_error&) {
+    }
+  }
+  std::ifstream fin(json);
+  Fuel fuel(fin);
+  fuel.WriteBinary(bin);
+  return fuel;
 }
 
 Fuel::Fuel(std::ifstream& fin) { Initialize(fin); }
@@ -32,32 +76,196 @@ void Fuel::Initialize(std::ifstream& fin) {
                      prop;
     }
   }
+  BuildGrid();
+}
+
+namespace {
+
+// Lower knot of the segment holding x and the weight of the upper one; values
+// are held constant outside the knots, as in math::Linterp.
+std::pair<size_t, double> Bracket(std::span<const double> knots, double x) {
+  if (knots.size() == 1 || x <= knots.front()) {
+    return {0, 0.0};
+  }
+  if (x >= knots.back()) {
+    return {knots.size() - 1, 0.0};
+  }
+  size_t k =
+      std::upper_bound(knots.begin(), knots.end(), x) - knots.begin() - 1;
+  return {k, (x - knots[k]) / (knots[k + 1] - knots[k])};
+}
+
+}  // namespace
+
+void Fuel::BuildGrid() {
+  std::set<double> temps;
+  for (const auto& [press, rows] : properties_) {
+    for (const auto& [temp, props] : rows) {
+      temps.insert(temp);
+    }
+  }
+  size_t n_p = properties_.size();
+  size_t n_t = temps.size();
+  auto buffer = std::make_shared<std::vector<double>>(
+      n_p + n_t + n_p * n_t * FuelProp::null, 0.0);
+  double* p_knot = buffer->data();
+  for (const auto& [press, rows] : properties_) {
+    *p_knot++ = press;
+  }
+  std::copy(temps.begin(), temps.end(), p_knot);
+  p_knots_ = {buffer->data(), n_p};
+  t_knots_ = {buffer->data() + n_p, n_t};
+  grid_ = {buffer->data() + n_p + n_t, n_p * n_t * FuelProp::null};
+  storage_ = buffer;
+  double* cell = buffer->data() + n_p + n_t;
+  for (const auto& [press, rows] : properties_) {
+    for (double t : t_knots_) {
+      auto bounds = math::GetParamBounds(rows, t);
+      for (int i = FuelProp::v; i < FuelProp::null; ++i) {
+        FuelProp prop = static_cast<FuelProp>(i);
+        cell[i] = math::Linterp(bounds.first->first, bounds.second->first,
+                                bounds.first->second.at(prop),
+                                bounds.second->second.at(prop), t);
+      }
+      cell += FuelProp::null;
+    }
+  }
+}
+
+Fuel Fuel::FromBinary(const std::string& filename) {
+  auto file = std::make_shared<MappedFile>(filename);
+  std::span<const std::byte> bytes = file->Bytes();
+  BinaryHeader header;
+  if (bytes.size() < sizeof(header)) {
+    throw std::runtime_error(filename + ": not a binary fuel file");
+  }
+  std::memcpy(&header, bytes.data(), sizeof(header));
+  if (std::memcmp(header.magic, BINARY_MAGIC, sizeof(BINARY_MAGIC)) != 0) {
+    throw std::runtime_error(filename + ": not a binary fuel file");
+  }
+  if (header.version != BINARY_VERSION || header.props != FuelProp::null) {
+    throw std::runtime_error(filename + ": unsupported version");
+  }
+  size_t count = 2 * header.total_temp + header.p_knots + header.t_knots +
+                 header.p_knots * header.t_knots * FuelProp::null;
+  std::span<const std::byte> payload = bytes.subspan(sizeof(header));
+  if (payload.size() != count * sizeof(double) ||
+      Checksum(payload) != header.checksum) {
+    throw std::runtime_error(filename + ": corrupted");
+  }
+
+  Fuel fuel;
+  const double* data = reinterpret_cast<const double*>(payload.data());
+  for (size_t i = 0; i < header.total_temp; ++i) {
+    fuel.total_temp_[data[i]] = data[header.total_temp + i];
+  }
+  data += 2 * header.total_temp;
+  fuel.p_knots_ = {data, header.p_knots};
+  data += header.p_knots;
+  fuel.t_knots_ = {data, header.t_knots};
+  data += header.t_knots;
+  fuel.grid_ = {data, header.p_knots * header.t_knots * FuelProp::null};
+  fuel.storage_ = file;
+  return fuel;
+}
+
+void Fuel::WriteBinary(std::ostream& os) const {
+  std::vector<double> payload;
+  payload.reserve(2 * total_temp_.size() + p_knots_.size() + t_knots_.size() +
+                  grid_.size());
+  for (const auto& [press, temp] : total_temp_) {
+    payload.push_back(press);
+  }
+  for (const auto& [press, temp] : total_temp_) {
+    payload.push_back(temp);
+  }
+  payload.insert(payload.end(), p_knots_.begin(), p_knots_.end());
+  payload.insert(payload.end(), t_knots_.begin(), t_knots_.end());
+  payload.insert(payload.end(), grid_.begin(), grid_.end());
+  std::span<const std::byte> bytes = std::as_bytes(std::span(payload));
+
+  BinaryHeader header{};
+  std::memcpy(header.magic, BINARY_MAGIC, sizeof(BINARY_MAGIC));
+  header.version = BINARY_VERSION;
+  header.props = FuelProp::null;
+  header.total_temp = total_temp_.size();
+  header.p_knots = p_knots_.size();
+  header.t_knots = t_knots_.size();
+  header.checksum = Checksum(bytes);
+  os.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  os.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+}
+
+// Written to a temporary file and renamed, as the material cache, so that
+// concurrent runs never map a partial file. A file that cannot be written is
+// skipped.
+void Fuel::WriteBinary(const std::string& filename) const {
+  std::string tmp = filename + "." + std::to_string(getpid());
+  {
+    std::ofstream out(tmp, std::ios::binary);
+    WriteBinary(out);
+    if (!out) {
+      out.close();
+      std::remove(tmp.c_str());
+      return;
+    }
+  }
+  std::error_code ec;
+  std::filesystem::rename(tmp, filename, ec);
+  if (ec) {
+    std::remove(tmp.c_str());
+  }
+}
+
+uint64_t Fuel::Fingerprint() const {
+  std::vector<double> data;
+  for (const auto& [press, temp] : total_temp_) {
+    data.push_back(press);
+    data.push_back(temp);
+  }
+  data.insert(data.end(), p_knots_.begin(), p_knots_.end());
+  data.insert(data.end(), t_knots_.begin(), t_knots_.end());
+  data.insert(data.end(), grid_.begin(), grid_.end());
+  return Checksum(std::as_bytes(std::span(data)));
+}
+
+Fuel::Cell Fuel::Locate(double p, double t) const {
+  auto [ip, wp] = Bracket(p_knots_, p);
+  auto [it, wt] = Bracket(t_knots_, t);
+  size_t row = t_knots_.size() * FuelProp::null;
+  size_t t_next = it + 1 < t_knots_.size() ? FuelProp::null : 0;
+  size_t p_next = ip + 1 < p_knots_.size() ? row : 0;
+  const double* v00 = grid_.data() + ip * row + it * FuelProp::null;
+  return {v00, v00 + t_next, v00 + p_next, v00 + p_next + t_next, wp, wt};
 }
 
 PropValues Fuel::GetProperties(double p, double t) const {
-  auto p_b = math::GetParamBounds(properties_, p);
-  auto t1_b = math::GetParamBounds(p_b.first->second, t);
-  auto t2_b = math::GetParamBounds(p_b.second->second, t);
+  Cell cell = Locate(p, t);
   PropValues res;
+  res[FuelProp::p] = p;
+  res[FuelProp::t] = t;
   for (int i = FuelProp::v; i < FuelProp::null; ++i) {
-    double param1 =
-        math::Linterp(t1_b.first->first, t1_b.second->first,
-                      t1_b.first->second.at(static_cast<FuelProp>(i)),
-                      t1_b.second->second.at(static_cast<FuelProp>(i)), t);
-    double param2 =
-        math::Linterp(t2_b.first->first, t2_b.second->first,
-                      t2_b.first->second.at(static_cast<FuelProp>(i)),
-                      t2_b.second->second.at(static_cast<FuelProp>(i)), t);
-    res[static_cast<FuelProp>(i)] =
-        math::Linterp(p_b.first->first, p_b.second->first, param1, param2, p);
+    res[i] = cell(i);
   }
   return res;
 }
 
+const Properties& Fuel::GetProperties() const {
+  if (properties_.empty()) {
+    throw std::logic_error("fuel tables are not kept when loaded from binary");
+  }
+  return properties_;
+}
+
 double Fuel::GetTotalTemp(double p) const {
   auto bounds = math::GetParamBounds(total_temp_, p);
   return math::Linterp(bounds.first->first, bounds.second->first,
                        bounds.first->second, bounds.second->second, p);
 }
 
+double Fuel::GetTotalTemp(double p,
+                          math::Cursor<double, double> &cursor) const {
+  return math::Linterp(total_temp_, p, cursor);
+}
+
 }  // namespace fuel
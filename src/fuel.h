@@ -1,9 +1,15 @@
 #pragma once
 
+#include <array>
 #include <map>
+#include <memory>
+#include <ostream>
+#include <span>
 #include <string>
 #include <vector>
 
+#include "common.h"
+
 namespace fuel {
 
 enum FuelProp {
@@ -61,23 +67,86 @@ const std::vector<std::string> PROP_NAMES{"P, Pa",
                                           "m_frac_co2",
                                           "m_frac_n"};
 
-using PropValues = std::map<FuelProp, double>;
-using Properties = std::map<double, std::map<double, PropValues>>;
+// Property values at one state, indexed by FuelProp.
+using PropValues = std::array<double, FuelProp::null>;
+using PropTable = std::map<FuelProp, double>;
+using Properties = std::map<double, std::map<double, PropTable>>;
 using TotalTemp = std::map<double, double>;
 
 class Fuel {
  private:
   TotalTemp total_temp_;
   Properties properties_;
+  // Properties resampled on the pressure knots and the union of the
+  // temperature knots, stored as [p][T][prop]. Each pressure row is linear
+  // between the merged knots, so bilinear interpolation on the grid gives the
+  // same values as the tables. The views point into storage_, which is either
+  // an owned buffer or a mapped binary fuel file; copies share it.
+  std::shared_ptr<const void> storage_;
+  std::span<const double> p_knots_;
+  std::span<const double> t_knots_;
+  std::span<const double> grid_;
+
+  // Grid corners around one (p, T) state and the interpolation weights;
+  // evaluating a property costs three multiply-adds.
+  struct Cell {
+    const double* v00;
+    const double* v01;
+    const double* v10;
+    const double* v11;
+    double wp;
+    double wt;
+
+    double operator()(size_t prop) const {
+      double param1 = v00[prop] + (v01[prop] - v00[prop]) * wt;
+      double param2 = v10[prop] + (v11[prop] - v10[prop]) * wt;
+      return param1 + (param2 - param1) * wp;
+    }
+  };
+
+  Fuel() = default;
   void Initialize(std::ifstream& fin);
+  void BuildGrid();
+  Cell Locate(double p, double t) const;
  public:
   Fuel(const TotalTemp &total_temp, const Properties &properties)
-      : total_temp_(total_temp), properties_(properties) {}
+      : total_temp_(total_temp), properties_(properties) {
+    BuildGrid();
+  }
   Fuel(const std::string &name);
   Fuel(std::ifstream &fin);
+  // Fuel of the JSON file json through its binary file bin, which is rebuilt
+  // when it is missing, stale or damaged.
+  static Fuel Load(const std::string &json, const std::string &bin);
+  // Maps a file written by WriteBinary. Only the grid and the total
+  // temperatures are restored, not the nested tables.
+  static Fuel FromBinary(const std::string &filename);
+  void WriteBinary(std::ostream &os) const;
+  void WriteBinary(const std::string &filename) const;
+  // Hash of the grid and the total temperatures, for keying derived caches.
+  uint64_t Fingerprint() const;
+  std::span<const double> PressureKnots() const { return p_knots_; }
+  std::span<const double> TemperatureKnots() const { return t_knots_; }
   PropValues GetProperties(double P, double T) const;
+  double GetProperty(double p, double t, FuelProp prop) const {
+    return Locate(p, t)(prop);
+  }
+  // Interpolates only the listed properties; the other entries but p and T
+  // are left zero.
+  template <FuelProp... Props>
+  PropValues GetProperties(double p, double t) const {
+    Cell cell = Locate(p, t);
+    PropValues res{};
+    res[FuelProp::p] = p;
+    res[FuelProp::t] = t;
+    ((res[Props] = cell(Props)), ...);
+    return res;
+  }
   double GetTotalTemp(double p) const;
-  const Properties &GetProperties() const { return properties_; }
+  double GetTotalTemp(double p, math::Cursor<double, double> &cursor) const;
+  // The nested tables; throws std::logic_error for a fuel mapped from a binary
+  // file, which has none.
+  const Properties &GetProperties() const;
   const TotalTemp &GetTotalTemperatures() const { return total_temp_; }
 };
 
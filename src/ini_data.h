@@ -3,6 +3,7 @@
 #include <fstream>
 #include <iostream>
 #include <map>
+#include <set>
 #include <string>
 #include <vector>
 
@@ -15,12 +16,58 @@ using json = nlohmann::json;
 
 class IniData {
  public:
+  struct HeatValues {
+    double alpha;
+    double te;
+    double trad;
+    double eps;
+    double q;
+  };
+
+  // The five tables are also compiled into one: values of all of them at the
+  // union of their knots, interleaved, so that a single segment search gives
+  // every value. Each table is linear between the merged knots, so the result
+  // is the same as five math::Linterp calls.
   struct HeatTransfer {
     std::map<double, double> alpha;
     std::map<double, double> te;
     std::map<double, double> trad;
     std::map<double, double> eps;
     std::map<double, double> q;
+    std::vector<double> knots;
+    std::vector<HeatValues> values;
+
+    void Compile() {
+      std::set<double> merged;
+      for (const auto* table : {&alpha, &te, &trad, &eps, &q}) {
+        for (const auto& [t, value] : *table) {
+          merged.insert(t);
+        }
+      }
+      knots.assign(merged.begin(), merged.end());
+      values.clear();
+      for (double t : knots) {
+        values.push_back({math::Linterp(alpha, t), math::Linterp(te, t),
+                          math::Linterp(trad, t), math::Linterp(eps, t),
+                          math::Linterp(q, t)});
+      }
+    }
+
+    HeatValues operator()(double t, math::SegmentCursor& cursor) const {
+      if (t <= knots.front()) {
+        return values.front();
+      }
+      if (t >= knots.back()) {
+        return values.back();
+      }
+      size_t k = cursor.Segment(knots, t);
+      const HeatValues& lo = values[k];
+      const HeatValues& hi = values[k + 1];
+      double w = (t - knots[k]) / (knots[k + 1] - knots[k]);
+      return {lo.alpha + (hi.alpha - lo.alpha) * w,
+              lo.te + (hi.te - lo.te) * w, lo.trad + (hi.trad - lo.trad) * w,
+              lo.eps + (hi.eps - lo.eps) * w, lo.q + (hi.q - lo.q) * w};
+    }
   };
 
   struct Domain {
@@ -42,6 +89,25 @@ class IniData {
     double solve_timestep;
     double output_timestep;
     std::optional<std::vector<double>> output_times;
+    bool fused_iteration = true;
+    std::size_t parallel_threshold = 100000;
+    std::size_t threads = 0;
+    double material_grid_step = 1.0;
+    // Resampling errors of the material grids are written to the case log;
+    // on by default for a grid step above 0.
+    bool material_grid_report = true;
+    bool exact_integration = false;
+    double props_tolerance = 0.0;
+    // The boundary tables of a wall are indexed by time, s, instead of wall
+    // temperature and presampled on the time grid, schedule_chunk steps at a
+    // time (0 for the whole run). "boundary time schedule" sets both walls.
+    bool time_schedule_left = false;
+    bool time_schedule_right = false;
+    std::size_t schedule_chunk = 0;
+    // The left tables are generated from the pressure history, see
+    // heat_exchange::PrepareBoundary; MainSolve refuses the ini until then.
+    bool generate_boundary = false;
+    bool boundary_generated = false;
   };
 
   struct InitialState {
@@ -97,6 +163,25 @@ class IniData {
     solver_settings_.output_timestep = ini_data_.at("output time step");
     solver_settings_.output_times =
         JSONArray2Vector<double>(ini_data_.at("output times"));
+    solver_settings_.fused_iteration =
+        ini_data_.value("fused iteration", true);
+    solver_settings_.parallel_threshold =
+        ini_data_.value("parallel threshold", std::size_t{100000});
+    solver_settings_.threads = ini_data_.value("threads", std::size_t{0});
+    solver_settings_.material_grid_step =
+        ini_data_.value("material grid step", 1.0);
+    solver_settings_.material_grid_report = ini_data_.value(
+        "material grid report", solver_settings_.material_grid_step > 0.0);
+    solver_settings_.exact_integration =
+        ini_data_.value("exact integration", false);
+    solver_settings_.props_tolerance = ini_data_.value("props tolerance", 0.0);
+    solver_settings_.time_schedule_left =
+        ini_data_.value("boundary time schedule", false);
+    solver_settings_.time_schedule_right = solver_settings_.time_schedule_left;
+    solver_settings_.schedule_chunk =
+        ini_data_.value("schedule chunk", std::size_t{0});
+    solver_settings_.generate_boundary =
+        ini_data_.value("generate boundary", false);
   }
 
   void ProcessInitialData() {
@@ -142,6 +227,8 @@ class IniData {
         JSON2DArray2Map(ini_data_.at("boundary right").at("eps"));
     boundary_conditions_.heat_right.q =
         JSON2DArray2Map(ini_data_.at("boundary right").at("q"));
+    boundary_conditions_.heat_left.Compile();
+    boundary_conditions_.heat_right.Compile();
   }
 
   void ProcessData() {
@@ -151,7 +238,7 @@ class IniData {
     ProcessBoundaryData();
   }
 
-  IniData(std::ifstream& fin) {
+  IniData(std::istream& fin) {
     ini_data_ = ordered_json::parse(fin);
     ProcessData();
   }
@@ -174,6 +261,16 @@ class IniData {
                  {"solve time step", {}},
                  {"output time step", {}},
                  {"output times", json::array()},
+                 {"fused iteration", true},
+                 {"parallel threshold", 100000},
+                 {"threads", 0},
+                 {"material grid step", 1.0},
+                 {"material grid report", true},
+                 {"exact integration", false},
+                 {"props tolerance", 0.0},
+                 {"boundary time schedule", false},
+                 {"schedule chunk", 0},
+                 {"generate boundary", false},
                  {"fuel", {}},
                  {"initial radius", {}},
                  {"throat radius", {}},
@@ -202,4 +299,13 @@ class IniData {
   const BoundaryConditions& GetBoundaryTable() const {
     return boundary_conditions_;
   }
+  // Installs left tables indexed by time, as generated from the pressure
+  // history, and reads the left wall from the time schedule; the right wall
+  // keeps its own indexing.
+  void SetHeatLeft(HeatTransfer heat) {
+    boundary_conditions_.heat_left = std::move(heat);
+    boundary_conditions_.heat_left.Compile();
+    solver_settings_.time_schedule_left = true;
+    solver_settings_.boundary_generated = true;
+  }
 };
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <atomic>
 #include <chrono>
 #include <iostream>
 #include <string_view>
@@ -58,19 +59,39 @@ class LogDuration {
   void Start() { start_time_ = Clock::now(); }
   void Stop() {
     auto end_time = Clock::now();
-    dur_ += end_time - start_time_;
+    Add(end_time - start_time_);
   }
+  // Adds time measured elsewhere, e.g. by the LocalDuration of one solver;
+  // safe to call from several threads at once.
+  void Add(Clock::duration dur) { dur_ += dur.count(); }
 
   ~LogDuration() {
     using namespace std::chrono;
     using namespace std::literals;
-    dst_stream_ << id_ << ": "sv << duration_cast<milliseconds>(dur_).count()
+    dst_stream_ << id_ << ": "sv
+                << duration_cast<milliseconds>(Clock::duration(dur_)).count()
                 << " ms"sv << std::endl;
   }
 
  private:
   const std::string id_;
   Clock::time_point start_time_;
-  Clock::duration dur_{};
+  std::atomic<Clock::rep> dur_{};
   std::ostream &dst_stream_;
 };
+
+// Timer owned by one thread, e.g. by one solver among the stations of a pool,
+// and added to a shared LogDuration once at the end, so that timing a hot
+// loop touches no shared state.
+class LocalDuration {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  void Start() { start_time_ = Clock::now(); }
+  void Stop() { dur_ += Clock::now() - start_time_; }
+  Clock::duration Total() const { return dur_; }
+
+ private:
+  Clock::time_point start_time_;
+  Clock::duration dur_{};
+};
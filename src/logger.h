@@ -19,6 +19,11 @@ class Logger {
       log_ << "Time: " << time << " s" << '\n';
     }
   }
+  void PropsSkipped(size_t skipped, size_t total) {
+    if (logging) {
+      log_ << "Props skipped: " << skipped << " of " << total << '\n';
+    }
+  }
   void SimpleIter(size_t iter, double max, double max_1, double max_N,
                   const Mesh& mesh) {
     log_.setf(std::ios_base::left);
@@ -27,8 +32,8 @@ class Logger {
     log_ << "Iter: " << std::setw(w) << iter << "Max: " << std::setw(w) << max
          << "Max left: " << std::setw(w) << max_1
          << "Max right: " << std::setw(w) << max_N << "T left: " << std::setw(w)
-         << mesh.GetVolumes().front().t_curr_ << "T right: " << std::setw(w)
-         << mesh.GetVolumes().back().t_curr_ << '\n';
+         << mesh.TCurr().front() << "T right: " << std::setw(w)
+         << mesh.TCurr().back() << '\n';
   }
 
   void Msg(const std::string& msg) { log_ << msg << '\n'; }
@@ -55,6 +60,12 @@ class Logger {
     log_ << '\n';
   }
 
+  void GridReport(const base::Database& base, const IniData& ini) {
+    log_ << "Material grids" << '\n';
+    base.PrintGridReport(log_, ini);
+    log_ << '\n';
+  }
+
   void InitialState(const IniData::InitialState& state) {
     log_.setf(std::ios_base::left);
     int w = 10;
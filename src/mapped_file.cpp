@@ -0,0 +1,45 @@
+#include "mapped_file.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <stdexcept>
+
+MappedFile::MappedFile(const std::string& filename) {
+  int fd = open(filename.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw std::runtime_error(filename + ": not exist");
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    close(fd);
+    throw std::runtime_error(filename + ": stat failed");
+  }
+  size_ = static_cast<size_t>(st.st_size);
+  if (size_ > 0) {
+    void* data = mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+    if (data == MAP_FAILED) {
+      close(fd);
+      throw std::runtime_error(filename + ": mmap failed");
+    }
+    data_ = static_cast<const std::byte*>(data);
+  }
+  close(fd);
+}
+
+MappedFile::~MappedFile() {
+  if (data_ != nullptr) {
+    munmap(const_cast<std::byte*>(data_), size_);
+  }
+}
+
+uint64_t Checksum(std::span<const std::byte> bytes) {
+  uint64_t hash = 14695981039346656037ULL;
+  for (std::byte b : bytes) {
+    hash ^= static_cast<uint64_t>(b);
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+
+// Read-only shared mapping of a whole file. Pages are loaded on first touch
+// and shared by every process that maps the same file.
+class MappedFile {
+ private:
+  const std::byte* data_ = nullptr;
+  size_t size_ = 0;
+
+ public:
+  explicit MappedFile(const std::string& filename);
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+  ~MappedFile();
+
+  std::span<const std::byte> Bytes() const { return {data_, size_}; }
+  size_t Size() const { return size_; }
+};
+
+// FNV-1a hash used to checksum the binary database files.
+uint64_t Checksum(std::span<const std::byte> bytes);
@@ -1,52 +1,553 @@
-#include "material.h"
-
-#include "common.h"
-
-namespace material {
-
-Material::Material(const std::string& name, double angle = 0.0) {
-  std::string str = FileName(name, 'm');
-  std::ifstream fin(str);
-  Initialize(fin, angle);
-}
-
-Material::Material(std::istream& fin, double angle = 0.0) { Initialize(fin, angle); }
-
-void Material::Initialize(std::istream& fin, double angle) {
-  nlohmann::json json = nlohmann::json::parse(fin);
-  name_ = json.at("name");
-  for (const auto& [name, props] : json.items()) {
-    for (size_t i = 0; i < props.back().size(); i++) {
-      if (stoe(name)) {
-        therm_props_[stoe(name).value()][props.front()[i]] = props.back()[i];
-      }
-    }
-  }
-  std::vector<std::pair<double, double>> l0(
-      therm_props_.at(Property::l0).begin(),
-      therm_props_.at(Property::l0).end());
-  std::vector<std::pair<double, double>> l90(
-      therm_props_.at(Property::l90).begin(),
-      therm_props_.at(Property::l90).end());
-  for (size_t i = 0; i < l0.size(); ++i) {
-    therm_props_[Property::l][l0[i].first] = l0[i].second * std::pow(std::cos(angle * M_PI / 180.0), 2) + l90[i].second * std::pow(std::cos((90.0 - angle) * M_PI / 180.0), 2);
-  }
-}
-
-double Material::GetProperty(double T, Property prop_name) const {
-  double res;
-  return math::Linterp(therm_props_.at(prop_name), T);
-}
-
-std::optional<Property> stoe(const std::string& name) {
-  static const std::unordered_map<std::string, Property> converter{
-      {"ro", Property::ro},         {"lambda_0", Property::l0},
-      {"lambda_90", Property::l90}, {"cp", Property::cp},
-      {"ko", Property::ko},         {"ea", Property::ea}};
-  if (converter.count(name)) {
-    return converter.at(name);
-  }
-  return std::nullopt;
-}
-
-}  // namespace material
+#include "material.h"
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+
+#include "common.h"
+#include "mapped_file.h"
+
+namespace material {
+
+Material::Material(const std::string& name, double angle, double grid_step) {
+  std::string str = FileName(name, 'm');
+  std::string bin = FileName(name, 'M');
+  if (!LoadCache(bin, str)) {
+    std::ifstream fin(str);
+    Parse(fin);
+    WriteCache(bin, str);
+  }
+  Finish(angle, grid_step);
+}
+
+Material::Material(std::istream& fin, double angle, double grid_step) {
+  Initialize(fin, angle, grid_step);
+}
+
+void Material::Initialize(std::istream& fin, double angle, double grid_step) {
+  Parse(fin);
+  Finish(angle, grid_step);
+}
+
+// Reads every table but l, which depends on the fiber angle.
+void Material::Parse(std::istream& fin) {
+  nlohmann::json json = nlohmann::json::parse(fin);
+  name_ = json.at("name");
+  Thermal therm_props;
+  for (const auto& [name, props] : json.items()) {
+    for (size_t i = 0; i < props.back().size(); i++) {
+      if (stoe(name)) {
+        therm_props[stoe(name).value()][props.front()[i]] = props.back()[i];
+      }
+    }
+  }
+  for (size_t i = 0; i < PROPERTY_COUNT; ++i) {
+    if (static_cast<Property>(i) == Property::l) {
+      continue;
+    }
+    auto it = therm_props.find(static_cast<Property>(i));
+    if (it == therm_props.end() || it->second.empty()) {
+      throw std::logic_error("Material " + name_ + " has no property " +
+                             std::to_string(i));
+    }
+    tables_[i].Build(it->second);
+  }
+}
+
+void Material::Finish(double angle, double grid_step) {
+  const Table& l0 = GetTable(Property::l0);
+  const Table& l90 = GetTable(Property::l90);
+  std::map<double, double> l;
+  for (size_t i = 0; i < l0.knots.size(); ++i) {
+    l[l0.knots[i]] = l0.values[i] * std::pow(std::cos(angle * M_PI / 180.0), 2) + l90.values[i] * std::pow(std::cos((90.0 - angle) * M_PI / 180.0), 2);
+  }
+  tables_[static_cast<size_t>(Property::l)].Build(l);
+  grids_.reset();
+  if (grid_step > 0.0) {
+    grids_ = std::make_unique<Grids>();
+    grids_->step = grid_step;
+  }
+}
+
+namespace {
+
+constexpr char CACHE_MAGIC[8] = {'1', 'D', 'H', 'M', 'A', 'T', '\0', '\0'};
+constexpr uint32_t CACHE_VERSION = 1;
+
+// Cache file: the header, the name padded to 8 bytes, then knots, values,
+// direct and inverse integrals of each table in Property order as native
+// doubles. The checksum covers everything after the header.
+struct CacheHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t props;
+  int64_t json_time;
+  uint64_t json_size;
+  uint64_t name_size;
+  uint64_t sizes[PROPERTY_COUNT];
+  uint64_t checksum;
+};
+
+size_t Padded(size_t size) { return (size + 7) / 8 * 8; }
+
+bool JsonStamp(const std::string& json, int64_t& time, uint64_t& size) {
+  std::error_code ec;
+  auto stamp = std::filesystem::last_write_time(json, ec);
+  if (ec) {
+    return false;
+  }
+  size = std::filesystem::file_size(json, ec);
+  time = stamp.time_since_epoch().count();
+  return !ec;
+}
+
+}  // namespace
+
+// Any mismatch sends the caller back to the JSON entry.
+bool Material::LoadCache(const std::string& filename, const std::string& json) {
+  int64_t json_time;
+  uint64_t json_size;
+  std::error_code ec;
+  if (!JsonStamp(json, json_time, json_size) ||
+      !std::filesystem::exists(filename, ec)) {
+    return false;
+  }
+  try {
+    MappedFile file(filename);
+    std::span<const std::byte> bytes = file.Bytes();
+    CacheHeader header;
+    if (bytes.size() < sizeof(header)) {
+      return false;
+    }
+    std::memcpy(&header, bytes.data(), sizeof(header));
+    if (std::memcmp(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0 ||
+        header.version != CACHE_VERSION || header.props != PROPERTY_COUNT ||
+        header.json_time != json_time || header.json_size != json_size) {
+      return false;
+    }
+    size_t count = 0;
+    for (uint64_t size : header.sizes) {
+      count += 4 * size;
+    }
+    std::span<const std::byte> payload = bytes.subspan(sizeof(header));
+    if (payload.size() != Padded(header.name_size) + count * sizeof(double) ||
+        Checksum(payload) != header.checksum) {
+      return false;
+    }
+    name_.assign(reinterpret_cast<const char*>(payload.data()),
+                 header.name_size);
+    const double* data = reinterpret_cast<const double*>(
+        payload.data() + Padded(header.name_size));
+    for (size_t i = 0; i < PROPERTY_COUNT; ++i) {
+      size_t n = header.sizes[i];
+      for (std::vector<double>* v :
+           {&tables_[i].knots, &tables_[i].values, &tables_[i].direct,
+            &tables_[i].inverse}) {
+        v->assign(data, data + n);
+        data += n;
+      }
+    }
+  } catch (const std::runtime_error&) {
+    return false;
+  }
+  return true;
+}
+
+// Written to a temporary file and renamed, so that concurrent runs never map
+// a partial image. A cache that cannot be written is skipped.
+void Material::WriteCache(const std::string& filename,
+                          const std::string& json) const {
+  CacheHeader header{};
+  if (!JsonStamp(json, header.json_time, header.json_size)) {
+    return;
+  }
+  std::string payload(Padded(name_.size()), '\0');
+  std::memcpy(payload.data(), name_.data(), name_.size());
+  for (size_t i = 0; i < PROPERTY_COUNT; ++i) {
+    const Table& table = tables_[i];
+    header.sizes[i] = table.knots.size();
+    for (const std::vector<double>* v :
+         {&table.knots, &table.values, &table.direct, &table.inverse}) {
+      payload.append(reinterpret_cast<const char*>(v->data()),
+                     v->size() * sizeof(double));
+    }
+  }
+  std::memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+  header.version = CACHE_VERSION;
+  header.props = PROPERTY_COUNT;
+  header.name_size = name_.size();
+  header.checksum = Checksum(std::as_bytes(std::span(payload)));
+
+  std::string tmp = filename + "." + std::to_string(getpid());
+  {
+    std::ofstream out(tmp, std::ios::binary);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(payload.data(), payload.size());
+    if (!out) {
+      out.close();
+      std::remove(tmp.c_str());
+      return;
+    }
+  }
+  std::error_code ec;
+  std::filesystem::rename(tmp, filename, ec);
+  if (ec) {
+    std::remove(tmp.c_str());
+  }
+}
+
+Thermal Material::GetProps() const {
+  Thermal therm_props;
+  for (size_t i = 0; i < PROPERTY_COUNT; ++i) {
+    std::map<double, double>& table = therm_props[static_cast<Property>(i)];
+    for (size_t k = 0; k < tables_[i].knots.size(); ++k) {
+      table.emplace(tables_[i].knots[k], tables_[i].values[k]);
+    }
+  }
+  return therm_props;
+}
+
+namespace {
+
+// Largest step that divides all knot offsets, so that every knot is a grid
+// node; 0 if there is none above round-off.
+double CommonStep(const std::vector<double>& knots) {
+  double t0 = knots.front();
+  double range = knots.back() - t0;
+  double tol = range * 1E-9;
+  double g = range;
+  for (double t : knots) {
+    double b = t - t0;
+    while (b > tol) {
+      double r = std::fmod(g, b);
+      g = b;
+      b = r;
+    }
+    if (g <= tol) {
+      return 0.0;
+    }
+  }
+  return g;
+}
+
+}  // namespace
+
+// The grid step is the requested one, reduced so that it divides every knot
+// interval; the resampled table then reproduces the original exactly. If that
+// would need more than GRID_MAX_NODES nodes the requested step is used as is
+// and the error report shows the deviation.
+void Material::BuildGrids() const {
+  double grid_step = grids_->step;
+  for (size_t i = 0; i < PROPERTY_COUNT; ++i) {
+    const Table& table = tables_[i];
+    Grid grid;
+    grid.t0 = table.knots.front();
+    double range = table.knots.back() - grid.t0;
+    size_t nodes = 1;
+    if (table.knots.size() > 1) {
+      double common = CommonStep(table.knots);
+      grid.step = common > 0.0 ? common / std::ceil(common / grid_step - 1E-9)
+                               : grid_step;
+      if (range / grid.step > GRID_MAX_NODES) {
+        grid.step = grid_step;
+      }
+      nodes = static_cast<size_t>(std::ceil(range / grid.step - 1E-9)) + 1;
+      grid.inv_step = 1.0 / grid.step;
+    }
+    grid.values.resize(nodes);
+    for (size_t k = 0; k < nodes; ++k) {
+      grid.values[k] = table.Interpolate(grid.t0 + k * grid.step);
+    }
+
+    GridError error{nodes, grid.step, 0.0, 0.0};
+    auto check = [&](double t) {
+      double exact = table.Interpolate(t);
+      double diff = std::abs(grid(t) - exact);
+      error.max_abs = std::max(error.max_abs, diff);
+      if (exact != 0.0) {
+        error.max_rel = std::max(error.max_rel, diff / std::abs(exact));
+      }
+    };
+    for (double t : table.knots) {
+      check(t);
+    }
+    for (size_t k = 0; k + 1 < nodes; ++k) {
+      check(grid.t0 + (k + 0.5) * grid.step);
+    }
+    grids_->grids[i] = std::move(grid);
+    grids_->errors[i] = error;
+  }
+  grids_->ready.store(true, std::memory_order_release);
+}
+
+double Material::GetProperty(double T, Property prop_name) const {
+  if (grids_) {
+    return GetGrid(prop_name)(T);
+  }
+  return GetTable(prop_name).Interpolate(T);
+}
+
+double Material::GetProperty(double T, Property prop_name,
+                             math::SegmentCursor& cursor) const {
+  if (grids_) {
+    return GetGrid(prop_name)(T);
+  }
+  return GetTable(prop_name).Interpolate(T, cursor);
+}
+
+double Material::MeanProperty(double Ta, double Tb, Property prop_name) const {
+  return GetTable(prop_name).Mean(std::min(Ta, Tb), std::max(Ta, Tb));
+}
+
+double Material::HarmonicMeanProperty(double Ta, double Tb,
+                                      Property prop_name) const {
+  return GetTable(prop_name).HarmonicMean(std::min(Ta, Tb), std::max(Ta, Tb));
+}
+
+void Material::GetProperty(std::span<const double> T, Property prop_name,
+                           std::span<double> out) const {
+  if (grids_) {
+    GetGrid(prop_name).Evaluate(T, out);
+    return;
+  }
+  const Table& table = GetTable(prop_name);
+  for (size_t k = 0; k < T.size(); ++k) {
+    out[k] = table.Interpolate(T[k]);
+  }
+}
+
+void Material::MeanProperty(std::span<const double> Ta,
+                            std::span<const double> Tb, Property prop_name,
+                            std::span<double> out) const {
+  const Table& table = GetTable(prop_name);
+  for (size_t k = 0; k < Ta.size(); ++k) {
+    out[k] = table.Mean(std::min(Ta[k], Tb[k]), std::max(Ta[k], Tb[k]));
+  }
+}
+
+void Material::HarmonicMeanProperty(std::span<const double> Ta,
+                                    std::span<const double> Tb,
+                                    Property prop_name,
+                                    std::span<double> out) const {
+  const Table& table = GetTable(prop_name);
+  for (size_t k = 0; k < Ta.size(); ++k) {
+    out[k] =
+        table.HarmonicMean(std::min(Ta[k], Tb[k]), std::max(Ta[k], Tb[k]));
+  }
+}
+
+#if defined(__x86_64__)
+namespace {
+
+// Four temperatures at a time: the cell index is computed arithmetically and
+// both cell ends are fetched with gathers. Clamping reproduces the scalar
+// branches, and temperatures past the last node take the last value as is.
+// Compiled for AVX2 whatever the build flags; returns the count done.
+__attribute__((target("avx2"))) size_t EvaluateAvx2(
+    const Grid& grid, std::span<const double> T, std::span<double> out) {
+  const std::vector<double>& values = grid.values;
+  const __m256d t0_v = _mm256_set1_pd(grid.t0);
+  const __m256d inv_v = _mm256_set1_pd(grid.inv_step);
+  const __m256d zero = _mm256_setzero_pd();
+  const __m256d last = _mm256_set1_pd(static_cast<double>(values.size() - 1));
+  const __m256d back = _mm256_set1_pd(values.back());
+  const __m128i cell_max = _mm_set1_epi32(static_cast<int>(values.size() - 2));
+  size_t k = 0;
+  for (; k + 4 <= T.size(); k += 4) {
+    __m256d u = _mm256_mul_pd(_mm256_sub_pd(_mm256_loadu_pd(&T[k]), t0_v),
+                              inv_v);
+    __m256d past = _mm256_cmp_pd(u, last, _CMP_GE_OQ);
+    u = _mm256_min_pd(_mm256_max_pd(u, zero), last);
+    __m128i cell = _mm256_cvttpd_epi32(u);
+    cell = _mm_min_epi32(cell, cell_max);
+    __m256d v0 = _mm256_i32gather_pd(values.data(), cell, 8);
+    __m256d v1 = _mm256_i32gather_pd(values.data() + 1, cell, 8);
+    __m256d frac = _mm256_sub_pd(u, _mm256_cvtepi32_pd(cell));
+    __m256d res =
+        _mm256_add_pd(v0, _mm256_mul_pd(_mm256_sub_pd(v1, v0), frac));
+    _mm256_storeu_pd(&out[k], _mm256_blendv_pd(res, back, past));
+  }
+  return k;
+}
+
+}  // namespace
+#endif
+
+// The gather kernel is picked at run time on x86-64, so a build without
+// NATIVE_ARCH uses it as well on machines that have AVX2.
+void Grid::Evaluate(std::span<const double> T, std::span<double> out) const {
+  size_t k = 0;
+  if (values.size() == 1) {
+    std::fill(out.begin(), out.begin() + T.size(), values.front());
+    return;
+  }
+#if defined(__AVX2__)
+  k = EvaluateAvx2(*this, T, out);
+#elif defined(__x86_64__)
+  static const bool avx2 = __builtin_cpu_supports("avx2");
+  if (avx2) {
+    k = EvaluateAvx2(*this, T, out);
+  }
+#endif
+  for (; k < T.size(); ++k) {
+    out[k] = (*this)(T[k]);
+  }
+}
+
+void Table::Build(const std::map<double, double>& table) {
+  knots.clear();
+  values.clear();
+  for (const auto& [t, value] : table) {
+    knots.push_back(t);
+    values.push_back(value);
+  }
+  direct.assign(knots.size(), 0.0);
+  inverse.assign(knots.size(), 0.0);
+  for (size_t k = 1; k < knots.size(); ++k) {
+    direct[k] = direct[k - 1] + Segment(knots[k - 1], values[k - 1], knots[k],
+                                        values[k], false);
+    inverse[k] = inverse[k - 1] + Segment(knots[k - 1], values[k - 1],
+                                          knots[k], values[k], true);
+  }
+}
+
+// Index of the segment holding t, clamped to [0, size - 2]. The halving loop
+// has a fixed trip count for a given table and compiles to conditional moves.
+size_t Table::Find(double t) const {
+  size_t base = 0;
+  size_t len = knots.size() - 1;
+  while (len > 1) {
+    size_t half = len / 2;
+    base = knots[base + half] <= t ? base + half : base;
+    len -= half;
+  }
+  return base;
+}
+
+double Table::Value(size_t k, double t) const {
+  return values[k] + (values[k + 1] - values[k]) / (knots[k + 1] - knots[k]) *
+                         (t - knots[k]);
+}
+
+double Table::Interpolate(double t) const {
+  if (t <= knots.front()) {
+    return values.front();
+  }
+  if (t >= knots.back()) {
+    return values.back();
+  }
+  return Value(Find(t), t);
+}
+
+double Table::Interpolate(double t, math::SegmentCursor& cursor) const {
+  if (t <= knots.front()) {
+    return values.front();
+  }
+  if (t >= knots.back()) {
+    return values.back();
+  }
+  return Value(cursor.Segment(knots, t), t);
+}
+
+// f is linear between (a, fa) and (b, fb); the integral of 1/f over such a
+// segment is (b - a) * ln(fb / fa) / (fb - fa).
+double Table::Segment(double a, double fa, double b, double fb,
+                      bool inverse) const {
+  if (!inverse) {
+    return (b - a) * (fa + fb) / 2.0;
+  }
+  double r = (fb - fa) / fa;
+  if (std::abs(r) < 1E-8) {
+    return (b - a) / fa * (1.0 - r / 2.0);
+  }
+  return (b - a) / fa * std::log1p(r) / r;
+}
+
+// Partial segments at the ends are integrated directly and only whole
+// segments come from the running sums, so narrow intervals do not lose
+// precision to cancellation.
+double Table::Integrate(double a, double b, bool inverse) const {
+  auto f = [inverse](double value) { return inverse ? 1.0 / value : value; };
+  double area = 0.0;
+  if (a < knots.front()) {
+    area += (std::min(b, knots.front()) - a) * f(values.front());
+    a = knots.front();
+  }
+  if (b > knots.back()) {
+    area += (b - std::max(a, knots.back())) * f(values.back());
+    b = knots.back();
+  }
+  if (a >= b) {
+    return area;
+  }
+  size_t ka = Find(a);
+  size_t kb = Find(b);
+  if (ka == kb) {
+    return area + Segment(a, Value(ka, a), b, Value(kb, b), inverse);
+  }
+  const std::vector<double>& sums = inverse ? this->inverse : direct;
+  area += Segment(a, Value(ka, a), knots[ka + 1], values[ka + 1], inverse);
+  area += sums[kb] - sums[ka + 1];
+  area += Segment(knots[kb], values[kb], b, Value(kb, b), inverse);
+  return area;
+}
+
+double Table::Mean(double a, double b) const {
+  if (b <= a) {
+    return Interpolate(a);
+  }
+  return Integrate(a, b, false) / (b - a);
+}
+
+double Table::HarmonicMean(double a, double b) const {
+  if (b <= a) {
+    return Interpolate(a);
+  }
+  return (b - a) / Integrate(a, b, true);
+}
+
+void Material::PrintGridReport(std::ostream& os) const {
+  if (!grids_) {
+    return;
+  }
+  static const std::vector<std::pair<Property, std::string>> names{
+      {Property::ro, "ro"}, {Property::l0, "lambda_0"},
+      {Property::l90, "lambda_90"}, {Property::l, "lambda"},
+      {Property::cp, "cp"}, {Property::ko, "ko"}, {Property::ea, "ea"}};
+  int w = 12;
+  std::streamsize precision = os.precision();
+  os << "Material: " << name_ << '\n';
+  os << std::setw(w) << "property" << std::setw(w) << "nodes" << std::setw(w)
+     << "step, K" << std::setw(w) << "max abs" << std::setw(w) << "max rel"
+     << '\n';
+  for (const auto& [prop, name] : names) {
+    const GridError& error = BuiltGrids().errors[static_cast<size_t>(prop)];
+    if (error.nodes == 0) {
+      continue;
+    }
+    os << std::setw(w) << name << std::setw(w) << error.nodes << std::setw(w)
+       << std::defaultfloat << error.step << std::setw(w) << std::scientific
+       << std::setprecision(2) << error.max_abs << std::setw(w)
+       << error.max_rel << std::defaultfloat << '\n';
+  }
+  os.precision(precision);
+}
+
+std::optional<Property> stoe(const std::string& name) {
+  static const std::unordered_map<std::string, Property> converter{
+      {"ro", Property::ro},         {"lambda_0", Property::l0},
+      {"lambda_90", Property::l90}, {"cp", Property::cp},
+      {"ko", Property::ko},         {"ea", Property::ea}};
+  if (converter.count(name)) {
+    return converter.at(name);
+  }
+  return std::nullopt;
+}
+
+}  // namespace material
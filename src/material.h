@@ -1,42 +1,160 @@
-#pragma once
-#include <algorithm>
-#include <fstream>
-#include <iomanip>
-#include <iostream>
-#include <map>
-#include <nlohmann/json.hpp>
-#include <optional>
-#include <set>
-#include <string>
-#include <vector>
-
-#include "common.h"
-
-namespace material {
-
-enum class Property { ro, l0, l90, l, cp, ko, ea, null };
-
-const std::vector<std::string> PROP_NAMES{
-    "ro, kg/m^3", "l0, W/m K", "l90, W/m K", "Cp, J/kg K", "ko", "ea"};
-
-using Thermal = std::unordered_map<Property, std::map<double, double>>;
-
-std::optional<Property> stoe(const std::string& name);
-
-class Material {
- private:
-  std::string name_;
-  Thermal therm_props_;
-
- public:
-  Material(const std::string& name, double angle);
-  Material(std::istream& fin, double angle);
-  void Initialize(std::istream& fin, double angle);
-
-  double GetProperty(double T, Property prop_name) const;
-  const Thermal& GetProps() const { return therm_props_; }
-  const std::string& GetName() const { return name_; }
-
-};
-
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <nlohmann/json.hpp>
+#include <optional>
+#include <set>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "common.h"
+
+namespace material {
+
+enum class Property { ro, l0, l90, l, cp, ko, ea, null };
+
+const std::vector<std::string> PROP_NAMES{
+    "ro, kg/m^3", "l0, W/m K", "l90, W/m K", "Cp, J/kg K", "ko", "ea"};
+
+using Thermal = std::unordered_map<Property, std::map<double, double>>;
+
+// Default step of the uniform temperature grid, K. A step of 0 keeps the
+// original tables.
+const double GRID_STEP = 1.0;
+const size_t GRID_MAX_NODES = 1000000;
+
+// Property table resampled on a uniform temperature grid. Values beyond the
+// grid are held constant, as in math::Linterp.
+struct Grid {
+  double t0 = 0.0;
+  double step = 0.0;
+  double inv_step = 0.0;
+  std::vector<double> values;
+
+  double operator()(double T) const {
+    double u = (T - t0) * inv_step;
+    if (!(u > 0.0)) {
+      return values.front();
+    }
+    if (u >= static_cast<double>(values.size() - 1)) {
+      return values.back();
+    }
+    size_t k = static_cast<size_t>(u);
+    return values[k] + (values[k + 1] - values[k]) * (u - k);
+  }
+  // Same as the scalar call for every element; uses AVX2 gathers on CPUs that
+  // have them.
+  void Evaluate(std::span<const double> T, std::span<double> out) const;
+};
+
+// Deviation of a grid from the piecewise-linear table it was built from.
+struct GridError {
+  size_t nodes;
+  double step;
+  double max_abs;
+  double max_rel;
+};
+
+// Piecewise-linear table stored as contiguous knot and value arrays, with
+// running integrals of f and 1/f at the knots for exact means over a
+// temperature interval. f is held constant outside the table, as in
+// math::Linterp.
+struct Table {
+  std::vector<double> knots;
+  std::vector<double> values;
+  std::vector<double> direct;
+  std::vector<double> inverse;
+
+  void Build(const std::map<double, double>& table);
+  bool Empty() const { return knots.empty(); }
+  double Interpolate(double t) const;
+  double Interpolate(double t, math::SegmentCursor& cursor) const;
+  // Integral of f, or of 1/f if inverse is set, over [a, b], a <= b.
+  double Integrate(double a, double b, bool inverse) const;
+  double Mean(double a, double b) const;
+  double HarmonicMean(double a, double b) const;
+
+ private:
+  size_t Find(double t) const;
+  double Value(size_t k, double t) const;
+  double Segment(double a, double fa, double b, double fb, bool inverse) const;
+};
+
+const size_t PROPERTY_COUNT = static_cast<size_t>(Property::null);
+
+std::optional<Property> stoe(const std::string& name);
+
+class Material {
+ private:
+  std::string name_;
+  std::array<Table, PROPERTY_COUNT> tables_;
+  // Resampled on the first grid lookup, so a material read only through the
+  // exact means never builds them; set only for a grid step above 0.
+  struct Grids {
+    double step;
+    std::once_flag once;
+    std::atomic<bool> ready = false;
+    std::array<Grid, PROPERTY_COUNT> grids;
+    std::array<GridError, PROPERTY_COUNT> errors{};
+  };
+  std::unique_ptr<Grids> grids_;
+
+  void Parse(std::istream& fin);
+  void Finish(double angle, double grid_step);
+  void BuildGrids() const;
+  const Grids& BuiltGrids() const {
+    if (!grids_->ready.load(std::memory_order_acquire)) {
+      std::call_once(grids_->once, [this] { BuildGrids(); });
+    }
+    return *grids_;
+  }
+  const Grid& GetGrid(Property prop_name) const {
+    return BuiltGrids().grids[static_cast<size_t>(prop_name)];
+  }
+  // Binary image of the parsed tables next to the JSON entry, tagged with the
+  // entry's modification time and size; l is derived again for each angle.
+  bool LoadCache(const std::string& filename, const std::string& json);
+  void WriteCache(const std::string& filename, const std::string& json) const;
+  const Table& GetTable(Property prop_name) const {
+    return tables_[static_cast<size_t>(prop_name)];
+  }
+
+ public:
+  Material(const std::string& name, double angle, double grid_step = GRID_STEP);
+  Material(std::istream& fin, double angle, double grid_step = GRID_STEP);
+  void Initialize(std::istream& fin, double angle, double grid_step);
+
+  double GetProperty(double T, Property prop_name) const;
+  // Same value; the cursor keeps the table segment of the previous call, for
+  // callers that follow one temperature history without the grids.
+  double GetProperty(double T, Property prop_name,
+                     math::SegmentCursor& cursor) const;
+  // Exact arithmetic and harmonic means of a property over [Ta, Tb] in either
+  // order; the value at Ta if the bounds coincide.
+  double MeanProperty(double Ta, double Tb, Property prop_name) const;
+  double HarmonicMeanProperty(double Ta, double Tb, Property prop_name) const;
+
+  // Batch forms of the calls above, element by element: out[k] is the value
+  // for T[k], or for the interval [Ta[k], Tb[k]].
+  void GetProperty(std::span<const double> T, Property prop_name,
+                   std::span<double> out) const;
+  void MeanProperty(std::span<const double> Ta, std::span<const double> Tb,
+                    Property prop_name, std::span<double> out) const;
+  void HarmonicMeanProperty(std::span<const double> Ta,
+                            std::span<const double> Tb, Property prop_name,
+                            std::span<double> out) const;
+  Thermal GetProps() const;
+  const std::string& GetName() const { return name_; }
+  void PrintGridReport(std::ostream& os) const;
+
+};
+
 }  // namespace material
\ No newline at end of file
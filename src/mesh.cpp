@@ -1,78 +1,180 @@
 #include "mesh.h"
 
+#include <algorithm>
 #include <cmath>
-#include <execution>
-
-double Volume::LambdaEff(const material::Material* mat,
-                         const Volume* vol) const {
-  auto lambda = [&vol, &mat, this](double x) -> double {
-    return 1 / mat->GetProperty(math::Linterp(x_, vol->x_, t_prev_step_,
-                                              vol->t_prev_step_, x),
-                                material::Property::l);
-  };
-  return (std::abs(x_ - vol->x_)) /
-         math::Integral(std::min(vol->x_, x_), std::max(vol->x_, x_), lambda);
-}
-
-double Volume::RoCpIntegral(const material::Material* mat, const Volume* vol,
-                            material::Property prop) const {
-  auto f = [&mat, &prop, &vol, this](double x) {
-    return mat->GetProperty(math::Linterp(x_, (x_ + vol->x_) / 2.0,
-                                          t_prev_step_, vol->t_prev_step_, x),
-                            prop);
-  };
-  return math::Integral(std::min(x_, (x_ + vol->x_) / 2.0),
-                        std::max(x_, (x_ + vol->x_) / 2.0), f);
-}
-
-void Volume::CalcProps() {
-  l_eff_left_ = 0.0;
-  l_eff_right_ = 0.0;
-  ro_sr_ = 0.0;
-  cp_sr_ = 0.0;
+#include <limits>
+
+// Never-evaluated faces hold NaN end temperatures and always compare dirty.
+bool Mesh::FaceDirty(size_t f) const {
+  const std::vector<double>& t = t_levels_[prev_step_];
+  return !(std::abs(t[f] - face_ta_[f]) <= props_tolerance_ &&
+           std::abs(t[f + 1] - face_tb_[f]) <= props_tolerance_);
+}
+
+void Mesh::InvalidateProps() {
+  std::fill(face_ta_.begin(), face_ta_.end(),
+            std::numeric_limits<double>::quiet_NaN());
+}
+
+// Dirty faces of the block are evaluated in contiguous runs, so the batch
+// kernels still see long ranges when most of a layer is changing.
+void Mesh::CalcFaceProps(const FaceBlock& block) {
+  const std::vector<double>& t = t_levels_[prev_step_];
+  for (size_t f = block.first; f < block.last; ++f) {
+    face_dirty_[f] = FaceDirty(f);
+  }
+  size_t f = block.first;
+  while (f < block.last) {
+    if (!face_dirty_[f]) {
+      ++f;
+      continue;
+    }
+    size_t first = f;
+    while (f < block.last && face_dirty_[f]) {
+      face_ta_[f] = t[f];
+      face_tb_[f] = t[f + 1];
+      ++f;
+    }
+    CalcFaceProps(*block.mat, first, f);
+  }
+}
+
+// T is linear in x between the nodes, so the integrals over x are means over
+// T. In exact mode they come from the material prefix tables, otherwise from
+// the N_INTEGRATION-point midpoint rule, evaluated FACE_BATCH faces at a time.
+void Mesh::CalcFaceProps(const material::Material& mat, size_t first,
+                         size_t last) {
+  const std::vector<double>& t = t_levels_[prev_step_];
+  size_t count = last - first;
+  std::span<const double> ta(t.data() + first, count);
+  std::span<const double> tb(t.data() + first + 1, count);
+  if (exact_integration_) {
+    mat.HarmonicMeanProperty(ta, tb, material::Property::l,
+                             std::span(face_l_).subspan(first, count));
+    mat.MeanProperty(ta, tb, material::Property::cp,
+                     std::span(face_cp_).subspan(first, count));
+    mat.MeanProperty(ta, tb, material::Property::ro,
+                     std::span(face_ro_).subspan(first, count));
+    return;
+  }
+  const size_t n = math::N_INTEGRATION;
+  std::array<double, FACE_BATCH * math::N_INTEGRATION> samples;
+  std::array<double, FACE_BATCH * math::N_INTEGRATION> values;
+  for (size_t batch = first; batch < last; batch += FACE_BATCH) {
+    size_t faces = std::min(FACE_BATCH, last - batch);
+    std::span<const double> in(samples.data(), faces * n);
+    std::span<double> out(values.data(), faces * n);
+    for (size_t f = 0; f < faces; ++f) {
+      double t0 = t[batch + f];
+      double dt = (t[batch + f + 1] - t0) / n;
+      for (size_t k = 0; k < n; ++k) {
+        samples[f * n + k] = t0 + dt * (k + 0.5);
+      }
+    }
+    mat.GetProperty(in, material::Property::l, out);
+    for (size_t f = 0; f < faces; ++f) {
+      double sum = 0.0;
+      for (size_t k = 0; k < n; ++k) {
+        sum += 1.0 / values[f * n + k];
+      }
+      face_l_[batch + f] = n / sum;
+    }
+    mat.GetProperty(in, material::Property::cp, out);
+    for (size_t f = 0; f < faces; ++f) {
+      double sum = 0.0;
+      for (size_t k = 0; k < n; ++k) {
+        sum += values[f * n + k];
+      }
+      face_cp_[batch + f] = sum / n;
+    }
+    mat.GetProperty(in, material::Property::ro, out);
+    for (size_t f = 0; f < faces; ++f) {
+      double sum = 0.0;
+      for (size_t k = 0; k < n; ++k) {
+        sum += values[f * n + k];
+      }
+      face_ro_[batch + f] = sum / n;
+    }
+  }
+}
+
+void Mesh::CalcProps(size_t i) {
+  l_eff_left_[i] = 0.0;
+  l_eff_right_[i] = 0.0;
+  double ro = 0.0;
+  double cp = 0.0;
   double l = 0.0;
-  if (mat_left_) {
-    l_eff_left_ = LambdaEff(mat_left_, this - 1);
-    cp_sr_ += RoCpIntegral(mat_left_, this - 1, material::Property::cp);
-    ro_sr_ += RoCpIntegral(mat_left_, this - 1, material::Property::ro);
-    l += std::abs(x_ - (this - 1)->x_) / 2.0;
+  if (mat_left_[i]) {
+    double half = std::abs((x_[i] + x_[i - 1]) / 2.0 - x_[i]);
+    l_eff_left_[i] = face_l_[i - 1];
+    cp += half * face_cp_[i - 1];
+    ro += half * face_ro_[i - 1];
+    l += std::abs(x_[i] - x_[i - 1]) / 2.0;
   }
-  if (mat_right_) {
-    l_eff_right_ = LambdaEff(mat_right_, this + 1);
-    cp_sr_ += RoCpIntegral(mat_right_, this + 1, material::Property::cp);
-    ro_sr_ += RoCpIntegral(mat_right_, this + 1, material::Property::ro);
-    l += std::abs(x_ - (this + 1)->x_) / 2.0;
+  if (mat_right_[i]) {
+    double half = std::abs((x_[i] + x_[i + 1]) / 2.0 - x_[i]);
+    l_eff_right_[i] = face_l_[i];
+    cp += half * face_cp_[i];
+    ro += half * face_ro_[i];
+    l += std::abs(x_[i] - x_[i + 1]) / 2.0;
   }
-  cp_sr_ /= l;
-  ro_sr_ /= l;
+  cp_sr_[i] = cp / l;
+  ro_sr_[i] = ro / l;
 }
 
 void Mesh::AddVolume(const std::map<double, double>& t_init, double r0,
                      double dx) {
   double x;
-  if (volumes_.empty()) {
+  if (x_.empty()) {
     x = r0;
   } else {
-    x = volumes_.back().x_ + dx;
+    x = x_.back() + dx;
   }
+  double t;
   if (t_init.size() == 1) {
-    volumes_.emplace_back(x, t_init.begin()->second);
+    t = t_init.begin()->second;
   } else {
-    volumes_.emplace_back(x, math ::Linterp(t_init, x));
+    t = math ::Linterp(t_init, x);
   }
+  x_.push_back(x);
+  for (std::vector<double>& level : t_levels_) {
+    level.push_back(t);
+  }
+  mat_left_.push_back(nullptr);
+  mat_right_.push_back(nullptr);
 }
 
-Mesh::Mesh(const base::Database& base, const IniData& ini_data)
-    : database_(base), ini_data_(ini_data) {
+Mesh::Mesh(const base::Database& base, const IniData& ini_data,
+           std::shared_ptr<ThreadPool> pool)
+    : database_(base),
+      ini_data_(ini_data),
+      exact_integration_(ini_data.GetSolverSettings().exact_integration),
+      props_tolerance_(ini_data.GetSolverSettings().props_tolerance),
+      pool_(std::move(pool)) {
+  if (!pool_) {
+    SetThreads(ini_data_.GetSolverSettings().threads);
+  }
   InitializeMesh(ini_data_.GetDomainSettings(), ini_data_.GetInitialState());
 }
 
 void Mesh::InitializeMesh(const IniData::Domain& domain,
                           const IniData::InitialState& ini_state) {
   const auto& ini = ini_data_.GetDomainSettings();
-  volumes_.clear();
-  volumes_.reserve(
-      std::accumulate(ini.subdivisions.begin(), ini.subdivisions.end(), 0));
+  size_t size =
+      std::accumulate(ini.subdivisions.begin(), ini.subdivisions.end(), 1);
+  x_.clear();
+  x_.reserve(size);
+  mat_left_.clear();
+  mat_left_.reserve(size);
+  mat_right_.clear();
+  mat_right_.reserve(size);
+  for (std::vector<double>& level : t_levels_) {
+    level.clear();
+    level.reserve(size);
+  }
+  curr_ = 0;
+  prev_iter_ = 1;
+  prev_step_ = 2;
 
   AddVolume(ini_state.t_initial, domain.initial_radius.value());
 
@@ -80,72 +182,154 @@ void Mesh::InitializeMesh(const IniData::Domain& domain,
     double dx = ini.thickness[i] / ini.subdivisions[i];
     for (int j = 1; j <= ini.subdivisions[i]; ++j) {
       AddVolume(ini_state.t_initial, domain.initial_radius.value(), dx);
-      volumes_.back().mat_left_ = &database_.GetMaterial(ini.mat_names[i]);
-      (&volumes_.back() - 1)->mat_right_ =
-          &database_.GetMaterial(ini.mat_names[i]);
+      const material::Material& mat = database_.GetMaterial(
+          ini.mat_names[i], ini.angles[i],
+          ini_data_.GetSolverSettings().material_grid_step);
+      mat_left_.back() = &mat;
+      *(mat_right_.end() - 2) = &mat;
     }
   }
 
+  dx_left_.assign(x_.size(), 0.0);
+  dx_right_.assign(x_.size(), 0.0);
+  r_left_.assign(x_.size(), 1.0);
+  r_right_.assign(x_.size(), 1.0);
+  r_.assign(x_.size(), 1.0);
+  l_eff_left_.assign(x_.size(), 0.0);
+  l_eff_right_.assign(x_.size(), 0.0);
+  cp_sr_.assign(x_.size(), 0.0);
+  ro_sr_.assign(x_.size(), 0.0);
+  face_l_.assign(x_.size() - 1, 0.0);
+  face_cp_.assign(x_.size() - 1, 0.0);
+  face_ro_.assign(x_.size() - 1, 0.0);
+  face_ta_.assign(x_.size() - 1, std::numeric_limits<double>::quiet_NaN());
+  face_tb_.assign(x_.size() - 1, std::numeric_limits<double>::quiet_NaN());
+  face_dirty_.assign(x_.size() - 1, 1);
+  PlanFaceBlocks();
+
   dxCalc();
 
   if (ini_data_.GetDomainSettings().axis_symmetry) {
     rCalc();
   }
+
+  GeomCalc();
 }
 
 void Mesh::dxCalc() {
-  for (size_t i = 1; i < volumes_.size() - 1; ++i) {
-    volumes_[i].dx_left_ = (volumes_[i].x_ - volumes_[i - 1].x_) / 2.0;
-    volumes_[i].dx_right_ = (volumes_[i + 1].x_ - volumes_[i].x_) / 2.0;
+  for (size_t i = 1; i < x_.size() - 1; ++i) {
+    dx_left_[i] = (x_[i] - x_[i - 1]) / 2.0;
+    dx_right_[i] = (x_[i + 1] - x_[i]) / 2.0;
     if (i == 1) {
-      volumes_[i - 1].dx_right_ = volumes_[i].dx_left_;
+      dx_right_[i - 1] = dx_left_[i];
       continue;
     }
-    if (i == volumes_.size() - 2) {
-      volumes_[i + 1].dx_left_ = volumes_[i].dx_right_;
+    if (i == x_.size() - 2) {
+      dx_left_[i + 1] = dx_right_[i];
     }
   }
 }
 
 void Mesh::rCalc() {
-  if (volumes_.front().x_ < EPS) {
-    volumes_.front().r_right_ = 0.0;
+  if (x_.front() < EPS) {
+    r_right_.front() = 0.0;
   } else {
-    volumes_.front().r_right_ =
-        (volumes_.front().x_ + volumes_.front().dx_right_) /
-        volumes_.front().x_;
+    r_right_.front() = (x_.front() + dx_right_.front()) / x_.front();
   }
-  for (size_t i = 1; i < volumes_.size() - 1; ++i) {
-    volumes_[i].r_left_ =
-        (volumes_[i - 1].x_ + volumes_[i].x_) / 2.0 / volumes_[i].x_;
-    volumes_[i].r_right_ =
-        (volumes_[i].x_ + volumes_[i + 1].x_) / 2.0 / volumes_[i].x_;
-    volumes_[i].r_ = volumes_[i].r_left_ + volumes_[i].r_right_;
+  for (size_t i = 1; i < x_.size() - 1; ++i) {
+    r_left_[i] = (x_[i - 1] + x_[i]) / 2.0 / x_[i];
+    r_right_[i] = (x_[i] + x_[i + 1]) / 2.0 / x_[i];
+    r_[i] = r_left_[i] + r_right_[i];
   }
-  volumes_.back().r_left_ = ((volumes_.end() - 2)->x_ + volumes_.back().x_) /
-                            2.0 / volumes_.back().x_;
+  r_left_.back() = (*(x_.end() - 2) + x_.back()) / 2.0 / x_.back();
 }
 
-void Mesh::UpdateVolumeProps() {
-  for (Volume& vol : volumes_) {
-    vol.CalcProps();
+void Mesh::GeomCalc() {
+  geom_left_.assign(x_.size(), 0.0);
+  geom_right_.assign(x_.size(), 0.0);
+  geom_center_.assign(x_.size(), 0.0);
+  for (size_t i = 1; i < x_.size() - 1; ++i) {
+    double dx = dx_left_[i] + dx_right_[i];
+    geom_left_[i] = r_left_[i] / (dx * dx);
+    geom_right_[i] = r_right_[i] / (dx * dx);
+    geom_center_[i] = 1.0 / (dx * dx);
   }
-  // for_each(std::execution::par, volumes_.begin(), volumes_.end(),
-  //          [](Volume& vol) { vol.CalcProps(); });
 }
 
-void Mesh::TPrevStepUpdate() {
-  for (Volume& vol : volumes_) {
-    vol.t_prev_step_ = vol.t_curr_;
+void Mesh::SetThreads(size_t threads) {
+  if (threads == 0) {
+    threads = std::thread::hardware_concurrency();
   }
+  SharePool(std::make_shared<ThreadPool>(threads));
 }
 
-void Mesh::TPrevIterUpdate() {
-  for (Volume& vol : volumes_) {
-    vol.t_prev_iter_ = vol.t_curr_;
+void Mesh::SharePool(std::shared_ptr<ThreadPool> pool) {
+  pool_ = std::move(pool);
+  PlanFaceBlocks();
+}
+
+// Blocks are whole cache lines of the face arrays and never cross a layer
+// boundary, so each one is a single material.
+void Mesh::PlanFaceBlocks() {
+  face_blocks_.clear();
+  if (x_.size() < 2 || !pool_) {
+    return;
+  }
+  size_t faces = x_.size() - 1;
+  size_t chunks = pool_->Size() == 1 ? 1 : pool_->Size() * 4;
+  size_t chunk = ((faces + chunks - 1) / chunks + 7) / 8 * 8;
+  size_t first = 0;
+  while (first < faces) {
+    size_t last = first + 1;
+    while (last < faces && mat_right_[last] == mat_right_[first] &&
+           last - first < chunk) {
+      ++last;
+    }
+    face_blocks_.push_back({first, last, mat_right_[first]});
+    first = last;
   }
 }
 
+// Face properties are computed per block through the batch kernels, then each
+// volume with a recomputed face sums its two half-cells. Volumes are split
+// into chunks of whole cache lines of the field arrays.
+void Mesh::UpdateVolumeProps() {
+  pool_->ParallelFor(face_blocks_.size(),
+                     [&](size_t k) { CalcFaceProps(face_blocks_[k]); });
+  size_t size = x_.size();
+  size_t chunks = pool_->Size() == 1 ? 1 : pool_->Size() * 4;
+  size_t chunk = ((size + chunks - 1) / chunks + 7) / 8 * 8;
+  chunks = (size + chunk - 1) / chunk;
+  std::vector<size_t> skipped(chunks, 0);
+  pool_->ParallelFor(chunks, [&](size_t k) {
+    for (size_t i = k * chunk; i < std::min(size, (k + 1) * chunk); ++i) {
+      if ((i > 0 && face_dirty_[i - 1]) || (i + 1 < size && face_dirty_[i])) {
+        CalcProps(i);
+      } else {
+        ++skipped[k];
+      }
+    }
+  });
+  skipped_volumes_ = std::accumulate(skipped.begin(), skipped.end(), size_t{0});
+}
+
+size_t Mesh::FreeLevel() const {
+  size_t level = 0;
+  while (level == prev_step_ || level == prev_iter_) {
+    ++level;
+  }
+  return level;
+}
+
+// The new step starts from the current field: prev_step_ aliases curr_ until
+// the first TPrevIterUpdate moves curr_ to a free buffer.
+void Mesh::TPrevStepUpdate() { prev_step_ = curr_; }
+
+void Mesh::TPrevIterUpdate() {
+  prev_iter_ = curr_;
+  curr_ = FreeLevel();
+}
+
 void Mesh::PrintGeomDebug(std::ostream& out) const {
   out.setf(std::ios_base::left);
   int w = 15;
@@ -153,17 +337,17 @@ void Mesh::PrintGeomDebug(std::ostream& out) const {
       << "T_prev_step, K" << std::setw(w) << "T_prev_iter, K" << std::setw(w)
       << "dx" << std::setw(w) << "Mat_left" << std::setw(w) << "Mat_right"
       << '\n';
-  for (const Volume& vol : volumes_) {
-    out << std::setw(w) << vol.x_ << std::setw(w) << vol.t_curr_ << std::setw(w)
-        << vol.t_prev_step_ << std::setw(w) << vol.t_prev_iter_ << std::setw(w)
-        << vol.dx_left_ + vol.dx_right_;
-    if (vol.mat_left_) {
-      out << std::setw(w) << vol.mat_left_->GetName();
+  for (size_t i = 0; i < x_.size(); ++i) {
+    out << std::setw(w) << x_[i] << std::setw(w) << TCurr()[i] << std::setw(w)
+        << TPrevStep()[i] << std::setw(w) << TPrevIter()[i] << std::setw(w)
+        << dx_left_[i] + dx_right_[i];
+    if (mat_left_[i]) {
+      out << std::setw(w) << mat_left_[i]->GetName();
     } else {
       out << std::setw(w) << "";
     }
-    if (vol.mat_right_) {
-      out << std::setw(w) << vol.mat_right_->GetName();
+    if (mat_right_[i]) {
+      out << std::setw(w) << mat_right_[i]->GetName();
     } else {
       out << std::setw(w) << "";
     }
@@ -175,8 +359,8 @@ void Mesh::Print(std::ostream& out) const {
   out.setf(std::ios_base::left);
   int w = 15;
   out << "x, m" << ';' << "T, K" << '\n';
-  for (const Volume& vol : volumes_) {
-    out << vol.x_ << ';' << vol.t_curr_ << '\n';
+  for (size_t i = 0; i < x_.size(); ++i) {
+    out << x_[i] << ';' << TCurr()[i] << '\n';
   }
 }
 
@@ -186,20 +370,20 @@ void Mesh::PrintThermDebug(std::ostream& out) const {
   out << std::setw(w) << "x, m" << std::setw(w) << "l_eff_left" << std::setw(w)
       << "l_eff_right" << std::setw(w) << "cp_sr" << std::setw(w) << "ro_sr"
       << '\n';
-  for (const Volume& vol : volumes_) {
-    out << std::setw(w) << vol.x_ << std::setw(w) << vol.l_eff_left_
-        << std::setw(w) << vol.l_eff_right_ << std::setw(w) << vol.cp_sr_
-        << std::setw(w) << vol.ro_sr_;
-    if (vol.mat_left_) {
-      out << std::setw(w) << vol.mat_left_->GetName();
+  for (size_t i = 0; i < x_.size(); ++i) {
+    out << std::setw(w) << x_[i] << std::setw(w) << l_eff_left_[i]
+        << std::setw(w) << l_eff_right_[i] << std::setw(w) << cp_sr_[i]
+        << std::setw(w) << ro_sr_[i];
+    if (mat_left_[i]) {
+      out << std::setw(w) << mat_left_[i]->GetName();
     } else {
       out << std::setw(w) << "";
     }
-    if (vol.mat_right_) {
-      out << std::setw(w) << vol.mat_right_->GetName();
+    if (mat_right_[i]) {
+      out << std::setw(w) << mat_right_[i]->GetName();
     } else {
       out << std::setw(w) << "";
     }
     out << '\n';
   }
-}
\ No newline at end of file
+}
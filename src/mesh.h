@@ -1,10 +1,14 @@
 #pragma once
+#include <array>
+#include <cassert>
 #include <cstdlib>
 #include <iomanip>
 #include <iostream>
 #include <list>
 #include <map>
+#include <memory>
 #include <numeric>
+#include <span>
 #include <string>
 #include <unordered_set>
 #include <variant>
@@ -15,48 +19,86 @@
 #include "ini_data.h"
 #include "material.h"
 #include "math.h"
-
-struct Volume {
-  double x_;
-  double dx_left_ = 0.0;
-  double dx_right_ = 0.0;
-
-  double t_curr_;
-  double t_prev_step_;
-  double t_prev_iter_;
-
-  double l_eff_left_ = 0.0;
-  double l_eff_right_ = 0.0;
-  double r_left_ = 1.0;
-  double r_right_ = 1.0;
-  double r_ = 1.0;
-  double cp_sr_ = 0.0;
-  double ro_sr_ = 0.0;
-
-  const material::Material* mat_left_ = nullptr;
-  const material::Material* mat_right_ = nullptr;
-
-  Volume(double x, double t)
-      : x_(x), t_curr_(t), t_prev_iter_(t), t_prev_step_(t) {}
-
-  double LambdaEff(const material::Material* mat, const Volume* vol) const;
-  double RoCpIntegral(const material::Material* mat, const Volume* vol,
-                      material::Property prop) const;
-
-  void CalcProps();
-};
+#include "thread_pool.h"
 
 class Mesh {
  protected:
-  std::vector<Volume> volumes_;
+  std::vector<double> x_;
+  std::vector<double> dx_left_;
+  std::vector<double> dx_right_;
+  std::vector<double> r_left_;
+  std::vector<double> r_right_;
+  std::vector<double> r_;
+
+  // Static conduction coefficients of interior volumes: r_left/dx^2,
+  // r_right/dx^2 and 1/dx^2, where dx is the control volume width.
+  std::vector<double> geom_left_;
+  std::vector<double> geom_right_;
+  std::vector<double> geom_center_;
+
+  std::vector<double> l_eff_left_;
+  std::vector<double> l_eff_right_;
+  std::vector<double> cp_sr_;
+  std::vector<double> ro_sr_;
+
+  std::vector<const material::Material*> mat_left_;
+  std::vector<const material::Material*> mat_right_;
+
+  // Properties of the half-cells between nodes f and f + 1: effective
+  // conductivity and mean ro and cp over the temperature span. Both volumes
+  // of a face use the same values.
+  std::vector<double> face_l_;
+  std::vector<double> face_cp_;
+  std::vector<double> face_ro_;
+
+  // End temperatures each face was last evaluated at. A face is recomputed
+  // only when one of them has moved by more than props_tolerance_, and a
+  // volume only when one of its faces was.
+  std::vector<double> face_ta_;
+  std::vector<double> face_tb_;
+  std::vector<char> face_dirty_;
+  size_t skipped_volumes_ = 0;
+
+  // Contiguous faces [first, last) of one material, the unit of work of the
+  // batch property kernels. Layers are split into a few blocks per thread.
+  struct FaceBlock {
+    size_t first;
+    size_t last;
+    const material::Material* mat;
+  };
+  std::vector<FaceBlock> face_blocks_;
+  static constexpr size_t FACE_BATCH = 64;
+
+  // Time levels are rotated instead of copied: curr_, prev_iter_ and
+  // prev_step_ index into t_levels_.
+  std::array<std::vector<double>, 3> t_levels_;
+  size_t curr_ = 0;
+  size_t prev_iter_ = 1;
+  size_t prev_step_ = 2;
+
   const base::Database& database_;
   const IniData& ini_data_;
+  bool exact_integration_;
+  double props_tolerance_;
+
+  // Cases stepped one after another, as in a batch, can share one pool.
+  std::shared_ptr<ThreadPool> pool_;
 
   void AddVolume(const std::map<double, double>& t_init, double r0,
                  double dx = 0.0);
 
+  size_t FreeLevel() const;
+
+  void PlanFaceBlocks();
+  void CalcFaceProps(const FaceBlock& block);
+  void CalcFaceProps(const material::Material& mat, size_t first,
+                     size_t last);
+  bool FaceDirty(size_t f) const;
+  void CalcProps(size_t i);
+
  public:
-  Mesh(const base::Database& base, const IniData& ini_data);
+  Mesh(const base::Database& base, const IniData& ini_data,
+       std::shared_ptr<ThreadPool> pool = nullptr);
   void InitializeMesh(const IniData::Domain& domain,
                       const IniData::InitialState& ini_state);
 
@@ -64,15 +106,52 @@ class Mesh {
 
   void rCalc();
 
+  void GeomCalc();
+
   void TPrevStepUpdate();
 
   void TPrevIterUpdate();
 
   void UpdateVolumeProps();
-
-  double& TCurr(size_t id) { return volumes_[id].t_curr_; }
-
-  const std::vector<Volume>& GetVolumes() const { return volumes_; }
+  // Volumes whose properties were reused by the last UpdateVolumeProps.
+  size_t SkippedVolumes() const { return skipped_volumes_; }
+  // Makes the next UpdateVolumeProps recompute every face.
+  void InvalidateProps();
+
+  void SetThreads(size_t threads);
+  void SharePool(std::shared_ptr<ThreadPool> pool);
+  ThreadPool& Pool() { return *pool_; }
+  const std::shared_ptr<ThreadPool>& SharedPool() const { return pool_; }
+
+  size_t Size() const { return x_.size(); }
+  const base::Database& GetDatabase() const { return database_; }
+
+  std::span<double> TCurr() { return t_levels_[curr_]; }
+  std::span<const double> TCurr() const { return t_levels_[curr_]; }
+  std::span<const double> TPrevIter() const { return t_levels_[prev_iter_]; }
+  std::span<const double> TPrevStep() const { return t_levels_[prev_step_]; }
+
+  std::span<const double> X() const { return x_; }
+  std::span<const double> DxLeft() const { return dx_left_; }
+  std::span<const double> DxRight() const { return dx_right_; }
+  std::span<const double> RLeft() const { return r_left_; }
+  std::span<const double> RRight() const { return r_right_; }
+  std::span<const double> R() const { return r_; }
+  std::span<const double> GeomLeft() const { return geom_left_; }
+  std::span<const double> GeomRight() const { return geom_right_; }
+  std::span<const double> GeomCenter() const { return geom_center_; }
+
+  std::span<const double> LEffLeft() const { return l_eff_left_; }
+  std::span<const double> LEffRight() const { return l_eff_right_; }
+  std::span<const double> CpSr() const { return cp_sr_; }
+  std::span<const double> RoSr() const { return ro_sr_; }
+
+  std::span<const material::Material* const> MatLeft() const {
+    return mat_left_;
+  }
+  std::span<const material::Material* const> MatRight() const {
+    return mat_right_;
+  }
 
   void AddTx();
   void AddTt();
@@ -82,19 +161,45 @@ class Mesh {
   void Print(std::ostream& out) const;
 };
 
-struct TempCoord {
-  std::list<double> x;
-  std::list<double> temp;
-};
-
+// Snapshots of one run as a time-major matrix: row k holds the temperatures of
+// all volumes at time[k]. Coordinates and the interface volumes are stored
+// once. The first AddRow reserves all the rows of the run, so adding one
+// never reallocates and the span of an earlier row stays valid; a run streamed
+// to a ResultsWriter adds none and never allocates the matrix.
 struct Results {
-  std::list<double> time;
-  std::list<TempCoord> temp_coord_distr;
-  std::list<std::list<double>> bound_temp_distr;
-  void PrintBoundsDistr(std::ostream& os, const IniData& ini) const {
+  std::vector<double> x;
+  std::vector<size_t> interfaces;
+  std::vector<double> time;
+  std::vector<double> temp;
+  size_t planned_rows = 0;
+
+  void Init(std::span<const double> coords, std::vector<size_t> bounds,
+            size_t rows) {
+    x.assign(coords.begin(), coords.end());
+    interfaces = std::move(bounds);
+    time.clear();
+    temp.clear();
+    planned_rows = rows;
+  }
+  size_t Rows() const { return time.size(); }
+  std::span<double> AddRow(double t) {
+    if (time.empty()) {
+      time.reserve(planned_rows);
+      temp.reserve(planned_rows * x.size());
+    }
+    assert(time.size() < time.capacity() &&
+           temp.size() + x.size() <= temp.capacity());
+    time.push_back(t);
+    temp.resize(temp.size() + x.size());
+    return {temp.data() + temp.size() - x.size(), x.size()};
+  }
+  std::span<const double> Row(size_t k) const {
+    return {temp.data() + k * x.size(), x.size()};
+  }
+  // Single-row printers, shared with ResultsWriter, which formats each row
+  // as it arrives instead of keeping the matrix.
+  void PrintBoundsHeader(std::ostream& os, const IniData& ini) const {
     int w = 20;
-    auto time_it = time.begin();
-    auto distr_it = bound_temp_distr.begin();
     os.setf(std::ios_base::internal);
     os << std::setw(w) << "t, s" << std::setw(w)
        << "liquid - " + ini.GetDomainSettings().mat_names.front();
@@ -104,35 +209,37 @@ struct Results {
                 ini.GetDomainSettings().mat_names[i + 1];
     }
     os << '\n';
-    while (time_it != time.end()) {
-      os << std::setw(w) << std::fixed << std::setprecision(2) << *time_it;
-      for (double val : *distr_it) {
-        os << std::setw(w) << std::fixed << std::setprecision(2) << val;
-      }
-      os << '\n';
-      ++time_it;
-      ++distr_it;
+  }
+  void PrintBoundsRow(std::ostream& os, double t,
+                      std::span<const double> row) const {
+    int w = 20;
+    os << std::setw(w) << std::fixed << std::setprecision(2) << t;
+    for (size_t i : interfaces) {
+      os << std::setw(w) << std::fixed << std::setprecision(2) << row[i];
     }
+    os << '\n';
   }
-  void PrintXDistr(std::ostream& os) const {
+  void PrintXRow(std::ostream& os, double t,
+                 std::span<const double> row) const {
     int w = 10;
-    auto time_it = time.begin();
-    auto coord_it = temp_coord_distr.begin();
-    while (time_it != time.end()) {
-      os << "Time: " << std::fixed << std::setprecision(3) << *time_it << " sec"
-         << '\n';
-      auto x_it = coord_it->x.begin();
-      auto temp_it = coord_it->temp.begin();
-      os << std::setw(w) << "x, mm" << std::setw(w) << "T, K" << '\n';
-      while (x_it != coord_it->x.end()) {
-        os << std::setw(w) << std::fixed << std::setprecision(2)
-           << *x_it * 1000.0 << std::setw(w) << std::fixed
-           << std::setprecision(2) << *temp_it << '\n';
-        ++x_it;
-        ++temp_it;
-      }
-      ++time_it;
-      ++coord_it;
+    os << "Time: " << std::fixed << std::setprecision(3) << t << " sec"
+       << '\n';
+    os << std::setw(w) << "x, mm" << std::setw(w) << "T, K" << '\n';
+    for (size_t i = 0; i < x.size(); ++i) {
+      os << std::setw(w) << std::fixed << std::setprecision(2)
+         << x[i] * 1000.0 << std::setw(w) << std::fixed
+         << std::setprecision(2) << row[i] << '\n';
+    }
+  }
+  void PrintBoundsDistr(std::ostream& os, const IniData& ini) const {
+    PrintBoundsHeader(os, ini);
+    for (size_t k = 0; k < Rows(); ++k) {
+      PrintBoundsRow(os, time[k], Row(k));
+    }
+  }
+  void PrintXDistr(std::ostream& os) const {
+    for (size_t k = 0; k < Rows(); ++k) {
+      PrintXRow(os, time[k], Row(k));
     }
   }
 };
\ No newline at end of file
@@ -0,0 +1,91 @@
+#include "results_writer.h"
+
+#include <stdexcept>
+
+ResultsWriter::ResultsWriter(std::filesystem::path filename, size_t capacity)
+    : filename_(std::move(filename)), capacity_(capacity) {
+  x_filename_ = filename_;
+  x_filename_ += ".x";
+}
+
+ResultsWriter::~ResultsWriter() { Close(); }
+
+void ResultsWriter::Open(const IniData& ini, const Results& layout) {
+  out_.open(filename_);
+  x_out_.open(x_filename_);
+  if (!out_.is_open() || !x_out_.is_open()) {
+    throw std::runtime_error(filename_.string() + ": can not be written");
+  }
+  layout_.x = layout.x;
+  layout_.interfaces = layout.interfaces;
+  times_.assign(capacity_, 0.0);
+  temps_.assign(capacity_ * layout_.x.size(), 0.0);
+  head_ = 0;
+  tail_ = 0;
+  stalls_ = 0;
+  layout_.PrintBoundsHeader(out_, ini);
+  x_out_.flags(out_.flags());
+  out_.flush();
+  thread_ = std::thread([this] { Write(); });
+}
+
+std::span<double> ResultsWriter::Acquire(double t) {
+  size_t head = head_.load(std::memory_order_relaxed);
+  size_t tail = tail_.load(std::memory_order_acquire);
+  if (head - tail == capacity_) {
+    ++stalls_;
+    do {
+      tail_.wait(tail, std::memory_order_acquire);
+      tail = tail_.load(std::memory_order_acquire);
+    } while (head - tail == capacity_);
+  }
+  size_t slot = head % capacity_;
+  times_[slot] = t;
+  return {temps_.data() + slot * layout_.x.size(), layout_.x.size()};
+}
+
+void ResultsWriter::Publish() {
+  head_.store(head_.load(std::memory_order_relaxed) + 1,
+              std::memory_order_release);
+  head_.notify_one();
+}
+
+// Both files are flushed whenever the ring runs empty, so a long run shows
+// every snapshot the solver has passed on.
+void ResultsWriter::Write() {
+  size_t tail = tail_.load(std::memory_order_relaxed);
+  while (true) {
+    size_t head = head_.load(std::memory_order_acquire);
+    if ((head & ~kClosed) == tail) {
+      if (head & kClosed) {
+        break;
+      }
+      out_.flush();
+      x_out_.flush();
+      head_.wait(head, std::memory_order_acquire);
+      continue;
+    }
+    for (; tail != (head & ~kClosed); ++tail) {
+      size_t slot = tail % capacity_;
+      std::span<const double> row(temps_.data() + slot * layout_.x.size(),
+                                  layout_.x.size());
+      layout_.PrintBoundsRow(out_, times_[slot], row);
+      layout_.PrintXRow(x_out_, times_[slot], row);
+      tail_.store(tail + 1, std::memory_order_release);
+      tail_.notify_one();
+    }
+  }
+}
+
+void ResultsWriter::Close() {
+  if (!thread_.joinable()) {
+    return;
+  }
+  head_.fetch_or(kClosed, std::memory_order_release);
+  head_.notify_one();
+  thread_.join();
+  x_out_.close();
+  out_ << std::ifstream(x_filename_).rdbuf();
+  out_.close();
+  std::filesystem::remove(x_filename_);
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <span>
+#include <thread>
+#include <vector>
+
+#include "ini_data.h"
+#include "mesh.h"
+
+// Streams the snapshots of one run to a results file while the solver goes on.
+// The solver fills rows of a bounded single-producer single-consumer ring and
+// a writer thread formats and writes them; when the disk falls behind and the
+// ring is full, Acquire waits for a free row. The interface table goes to the
+// file as the rows arrive and the coordinate distributions to a side file
+// "<filename>.x", which Close appends, so the finished file is the same as
+// PrintBoundsDistr followed by PrintXDistr.
+class ResultsWriter {
+ private:
+  static constexpr size_t kClosed = size_t{1} << (sizeof(size_t) * 8 - 1);
+
+  std::filesystem::path filename_;
+  std::filesystem::path x_filename_;
+  std::ofstream out_;
+  std::ofstream x_out_;
+  size_t capacity_;
+  // Coordinates and interfaces of the run; holds no rows.
+  Results layout_;
+  std::vector<double> times_;
+  std::vector<double> temps_;
+  // Rows published by the solver and rows written by the thread; both only
+  // grow, the row index in the ring is the count modulo the capacity. Close
+  // sets kClosed in head_ to wake the thread for the last time.
+  alignas(64) std::atomic<size_t> head_ = 0;
+  alignas(64) std::atomic<size_t> tail_ = 0;
+  size_t stalls_ = 0;
+  std::thread thread_;
+
+  void Write();
+
+ public:
+  explicit ResultsWriter(std::filesystem::path filename, size_t capacity = 64);
+  ResultsWriter(const ResultsWriter&) = delete;
+  ResultsWriter& operator=(const ResultsWriter&) = delete;
+  ~ResultsWriter();
+
+  // Writes the table header and starts the thread.
+  void Open(const IniData& ini, const Results& layout);
+  bool IsOpen() const { return thread_.joinable(); }
+  // Row of the next snapshot at time t, valid until Publish.
+  std::span<double> Acquire(double t);
+  void Publish();
+  // Writes the remaining rows, joins the thread and assembles the file.
+  void Close();
+
+  size_t Rows() const { return tail_.load(std::memory_order_acquire); }
+  // Snapshots that had to wait for a free row.
+  size_t Stalls() const { return stalls_; }
+};
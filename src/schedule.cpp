@@ -0,0 +1,45 @@
+#include "schedule.h"
+
+#include <algorithm>
+
+// The step count repeats the time accumulation of MainSolve::Running and
+// BeginStep, so the last step is the one the solver actually takes.
+BoundarySchedule::BoundarySchedule(const IniData& ini)
+    : ini_(ini),
+      t_step_(ini.GetSolverSettings().solve_timestep),
+      chunk_(ini.GetSolverSettings().schedule_chunk),
+      left_(ini.GetSolverSettings().time_schedule_left),
+      right_(ini.GetSolverSettings().time_schedule_right) {
+  double solve_time = ini.GetSolverSettings().solve_time;
+  for (double time = 0.0; solve_time - time > EPS; time += t_step_) {
+    ++steps_;
+  }
+  if (chunk_ == 0 || chunk_ > steps_) {
+    chunk_ = std::max<size_t>(steps_, 1);
+  }
+  values_.resize(2 * chunk_);
+  Fill(1);
+}
+
+void BoundarySchedule::Seek(size_t step) {
+  if (step < first_ || step >= first_ + count_) {
+    Fill(step);
+  }
+}
+
+void BoundarySchedule::Fill(size_t first) {
+  const IniData::BoundaryConditions& bounds = ini_.GetBoundaryTable();
+  math::SegmentCursor left;
+  math::SegmentCursor right;
+  first_ = first;
+  count_ = std::min(chunk_, steps_ + 1 - std::min(first, steps_ + 1));
+  for (size_t k = 0; k < count_; ++k) {
+    double time = (first + k) * t_step_;
+    if (left_) {
+      values_[2 * k] = bounds.heat_left(time, left);
+    }
+    if (right_) {
+      values_[2 * k + 1] = bounds.heat_right(time, right);
+    }
+  }
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include <vector>
+
+#include "common.h"
+#include "ini_data.h"
+
+// Boundary values presampled on the solver time grid, for the walls whose
+// tables are indexed by time instead of wall temperature. Step n holds
+// the values at n * solve_timestep, n = 1..Steps(), as MainSolve counts its
+// steps. With a nonzero chunk the array holds only that many steps and Seek
+// refills it; otherwise the whole run is sampled once and Seek does nothing,
+// so one schedule can be read by several cases.
+class BoundarySchedule {
+ private:
+  const IniData& ini_;
+  double t_step_;
+  size_t steps_ = 0;
+  size_t chunk_;
+  size_t first_ = 0;
+  size_t count_ = 0;
+  bool left_;
+  bool right_;
+  // Left and right values of each step, interleaved.
+  std::vector<IniData::HeatValues> values_;
+
+  void Fill(size_t first);
+
+ public:
+  explicit BoundarySchedule(const IniData& ini);
+  size_t Steps() const { return steps_; }
+  // Whether the wall is read from the schedule; its values are not sampled
+  // otherwise.
+  bool HasLeft() const { return left_; }
+  bool HasRight() const { return right_; }
+  void Seek(size_t step);
+  const IniData::HeatValues& Left(size_t step) const {
+    return values_[2 * (step - first_)];
+  }
+  const IniData::HeatValues& Right(size_t step) const {
+    return values_[2 * (step - first_) + 1];
+  }
+};
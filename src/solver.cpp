@@ -4,6 +4,7 @@
 #include <ctime>
 #include <fstream>
 #include <iostream>
+#include <stdexcept>
 #include <string>
 #include <vector>
 
@@ -19,7 +20,7 @@ extern LogDuration dur_t_calc;
 
 MainSolve::MainSolve(Mesh& mesh, const IniData& ini, Results& res, Logger& log)
     : mesh_(mesh), ini_(ini), res_(res), log_(log) {
-  size_t size = mesh_.GetVolumes().size();
+  size_t size = mesh_.Size();
   alfa.resize(size);
   beta.resize(size);
   A.resize(size);
@@ -27,6 +28,28 @@ MainSolve::MainSolve(Mesh& mesh, const IniData& ini, Results& res, Logger& log)
   C.resize(size);
   F.resize(size);
 
+  if (size >= ini_.GetSolverSettings().parallel_threshold) {
+    tdma_ = std::make_unique<tridiag::Partitioned>(mesh_.Pool());
+    lower_.resize(size);
+    diag_.resize(size);
+    upper_.resize(size);
+    rhs_.resize(size);
+  }
+
+  if (ini_.GetSolverSettings().generate_boundary &&
+      !ini_.GetSolverSettings().boundary_generated) {
+    throw std::logic_error(
+        ini_.GetDomainSettings().name +
+        ": generated boundary requested, call heat_exchange::PrepareBoundary");
+  }
+  if (ini_.GetSolverSettings().material_grid_report) {
+    log_.GridReport(mesh_.GetDatabase(), ini_);
+  }
+  t_step = ini_.GetSolverSettings().solve_timestep;
+  if (ini_.GetSolverSettings().time_schedule_left ||
+      ini_.GetSolverSettings().time_schedule_right) {
+    schedule_ = std::make_shared<BoundarySchedule>(ini_);
+  }
   out_time_ = ini_.GetSolverSettings().output_timestep;
 
   for (double time = ini_.GetSolverSettings().output_timestep;
@@ -45,181 +68,361 @@ MainSolve::MainSolve(Mesh& mesh, const IniData& ini, Results& res, Logger& log)
     times_output.erase(last, times_output.end());
     std::sort(times_output.begin(), times_output.end());
   }
+
+  std::vector<size_t> interfaces;
+  for (size_t i = 0; i < mesh_.Size(); ++i) {
+    if (mesh_.MatLeft()[i] != mesh_.MatRight()[i]) {
+      interfaces.push_back(i);
+    }
+  }
+  res_.Init(mesh_.X(), std::move(interfaces), OutputCount());
+}
+
+// Replays the time accumulation of Running, BeginStep and EndStep, so the
+// count is exact whatever the rounding of the time sums.
+size_t MainSolve::OutputCount() const {
+  const IniData::SolverSettings& settings = ini_.GetSolverSettings();
+  size_t count = 0;
+  double out_time = settings.output_timestep;
+  double time = 0.0;
+  while (settings.solve_time - time > EPS) {
+    double prev_time = time;
+    time += settings.solve_timestep;
+    if (out_time > prev_time && out_time <= time) {
+      ++count;
+      out_time += settings.output_timestep;
+    }
+  }
+  return count;
+}
+
+MainSolve::~MainSolve() {
+  dur_res_write.Add(dur_res_write_.Total());
+  dur_prevsteps_update.Add(dur_prevsteps_update_.Total());
+  dur_volumeprops_update.Add(dur_volumeprops_update_.Total());
+  dur_abi.Add(dur_abi_.Total());
+  dur_t_calc.Add(dur_t_calc_.Total());
+}
+
+// Properties change once per time step, so the interior matrix and the
+// property-dependent boundary terms are assembled here rather than in every
+// iteration.
+void MainSolve::AssembleCoefficients() {
+  std::span<const double> l_eff_left = mesh_.LEffLeft();
+  std::span<const double> l_eff_right = mesh_.LEffRight();
+  std::span<const double> cp_sr = mesh_.CpSr();
+  std::span<const double> ro_sr = mesh_.RoSr();
+  std::span<const double> geom_left = mesh_.GeomLeft();
+  std::span<const double> geom_right = mesh_.GeomRight();
+  std::span<const double> geom_center = mesh_.GeomCenter();
+  std::span<const double> t_prev_step = mesh_.TPrevStep();
+  for (size_t i = 1; i < mesh_.Size() - 1; ++i) {
+    double rocp_dt = ro_sr[i] * cp_sr[i] / t_step;
+    A[i] = l_eff_right[i] * geom_right[i];
+    B[i] = (l_eff_right[i] + l_eff_left[i]) * geom_center[i] + rocp_dt;
+    C[i] = l_eff_left[i] * geom_left[i];
+    F[i] = -rocp_dt * t_prev_step[i];
+  }
+  if (tdma_) {
+    for (size_t i = 1; i < mesh_.Size() - 1; ++i) {
+      lower_[i] = -C[i];
+      diag_[i] = B[i];
+      upper_[i] = -A[i];
+      rhs_[i] = -F[i];
+    }
+  }
+
+  left_.dx = mesh_.DxRight().front() * 2.0;
+  left_.lr = l_eff_right.front() * mesh_.RRight().front();
+  left_.rocp_dx2 = ro_sr.front() * cp_sr.front() * left_.dx * left_.dx;
+  left_.storage = ro_sr.front() * cp_sr.front() * left_.dx *
+                  t_prev_step.front() / 2 / t_step;
+  right_.dx = mesh_.DxLeft().back() * 2.0;
+  right_.lr = l_eff_left.back() * mesh_.RLeft().back();
+  right_.rocp_dx2 = ro_sr.back() * cp_sr.back() * right_.dx * right_.dx;
+  right_.storage = ro_sr.back() * cp_sr.back() * right_.dx *
+                   t_prev_step.back() / 2 / t_step;
+}
+
+namespace {
+
+// sigma * (te^4 - tw^4) with squares instead of pow.
+double RadiationTerm(double te, double t_wall) {
+  double te2 = te * te;
+  double tw2 = t_wall * t_wall;
+  return math::SIGMA * (te2 * te2 - tw2 * tw2);
+}
+
+}  // namespace
+
+// Boundary tables are evaluated at the previous iteration temperature: the
+// current level is a free buffer until T_N and T fill it.
+IniData::HeatValues MainSolve::LeftHeat(double t_wall) const {
+  if (schedule_ && schedule_->HasLeft()) {
+    return schedule_->Left(step_);
+  }
+  return ini_.GetBoundaryTable().heat_left(t_wall, left_cursor_);
+}
+
+IniData::HeatValues MainSolve::RightHeat(double t_wall) const {
+  if (schedule_ && schedule_->HasRight()) {
+    return schedule_->Right(step_);
+  }
+  return ini_.GetBoundaryTable().heat_right(t_wall, right_cursor_);
+}
+
+SweepStart MainSolve::LeftBoundary(double t_wall) const {
+  IniData::HeatValues heat = LeftHeat(t_wall);
+  double aa = 2 * left_.lr * t_step /
+              (2 * left_.lr * t_step + left_.rocp_dx2 +
+               2 * heat.alpha * left_.dx * t_step);
+  return {aa, aa * left_.dx / left_.lr *
+                  (heat.q + heat.alpha * heat.te + left_.storage +
+                   heat.eps * RadiationTerm(heat.te, t_wall))};
+}
+
+BoundaryRow MainSolve::RightRow(double t_wall) const {
+  IniData::HeatValues heat = RightHeat(t_wall);
+  return {-2 * right_.lr * t_step,
+          2 * right_.lr * t_step + right_.rocp_dx2 +
+              2 * heat.alpha * right_.dx * t_step,
+          2 * right_.dx * t_step *
+              (heat.q + heat.alpha * heat.te + right_.storage +
+               heat.eps * RadiationTerm(heat.te, t_wall))};
+}
+
+double MainSolve::RightBoundary(double t_wall, double alfa_prev,
+                                double beta_prev) const {
+  BoundaryRow row = RightRow(t_wall);
+  return (row.rhs - row.lower * beta_prev) / (row.diag + row.lower * alfa_prev);
 }
 
 void MainSolve::ab_0() {
-  double aa;
-  lambda = mesh_.GetVolumes().front().l_eff_right_;
-  cp = mesh_.GetVolumes().front().cp_sr_;
-  ro = mesh_.GetVolumes().front().ro_sr_;
-  t_step = ini_.GetSolverSettings().solve_timestep;
-  dx = mesh_.GetVolumes().front().dx_right_ * 2.0;
-  double r = mesh_.GetVolumes().front().r_right_;
-  a = math::Linterp(ini_.GetBoundaryTable().heat_left.alpha,
-                    mesh_.GetVolumes().front().t_curr_);
-  te = math::Linterp(ini_.GetBoundaryTable().heat_left.te,
-                     mesh_.GetVolumes().front().t_curr_);
-  eps = math::Linterp(ini_.GetBoundaryTable().heat_left.eps,
-                      mesh_.GetVolumes().front().t_curr_);
-  trad = math::Linterp(ini_.GetBoundaryTable().heat_left.trad,
-                       mesh_.GetVolumes().front().t_curr_);
-  q = math::Linterp(ini_.GetBoundaryTable().heat_left.q,
-                    mesh_.GetVolumes().front().t_curr_);
-
-  aa = 2 * lambda * r * t_step /
-       (2 * lambda * r * t_step + cp * ro * dx * dx + 2 * a * dx * t_step);
-  alfa.front() = aa;
-  beta.front() =
-      aa * dx / lambda / r *
-      (q + a * te +
-       cp * ro * dx * mesh_.GetVolumes().front().t_prev_step_ / 2 / t_step +
-       eps * math::SIGMA *
-           (pow(te, 4) - pow(mesh_.GetVolumes().front().t_prev_iter_, 4)));
+  SweepStart start = LeftBoundary(mesh_.TPrevIter().front());
+  alfa.front() = start.alfa;
+  beta.front() = start.beta;
 }
 
 void MainSolve::ab_i_impl() {
-  for (size_t i = 1; i < mesh_.GetVolumes().size() - 1; ++i) {
-    lambda_l = mesh_.GetVolumes()[i].l_eff_left_;
-    lambda_r = mesh_.GetVolumes()[i].l_eff_right_;
-    cp = mesh_.GetVolumes()[i].cp_sr_;
-    ro = mesh_.GetVolumes()[i].ro_sr_;
-    dx = mesh_.GetVolumes()[i].dx_left_ + mesh_.GetVolumes()[i].dx_right_;
-    t_step = ini_.GetSolverSettings().solve_timestep;
-    double r_l = mesh_.GetVolumes()[i].r_left_;
-    double r_r = mesh_.GetVolumes()[i].r_right_;
-    double r = mesh_.GetVolumes()[i].r_;
-    A.at(i) = lambda_r * r_r / (dx * dx);
-    B.at(i) = (lambda_r + lambda_l) / (dx * dx) + ro * cp / t_step;
-    C.at(i) = lambda_l * r_l / (dx * dx);
-    F.at(i) = -ro * cp * mesh_.GetVolumes()[i].t_prev_step_ / t_step;
-    alfa.at(i) = A.at(i) / (B.at(i) - C.at(i) * alfa.at(i - 1));
-    beta.at(i) = (C.at(i) * beta.at(i - 1) - F.at(i)) /
-                 (B.at(i) - C.at(i) * alfa.at(i - 1));
+  for (size_t i = 1; i < mesh_.Size() - 1; ++i) {
+    double den = B[i] - C[i] * alfa[i - 1];
+    alfa[i] = A[i] / den;
+    beta[i] = (C[i] * beta[i - 1] - F[i]) / den;
   }
 }
 
 void MainSolve::T_N() {
-  double bn;
-  lambda = mesh_.GetVolumes().back().l_eff_left_;
-  cp = mesh_.GetVolumes().back().cp_sr_;
-  ro = mesh_.GetVolumes().back().ro_sr_;
-  double r = mesh_.GetVolumes().back().r_left_;
-  a = math::Linterp(ini_.GetBoundaryTable().heat_right.alpha,
-                    mesh_.GetVolumes().back().t_curr_);
-  te = math::Linterp(ini_.GetBoundaryTable().heat_right.te,
-                     mesh_.GetVolumes().back().t_curr_);
-  eps = math::Linterp(ini_.GetBoundaryTable().heat_right.eps,
-                      mesh_.GetVolumes().back().t_curr_);
-  trad = math::Linterp(ini_.GetBoundaryTable().heat_right.trad,
-                       mesh_.GetVolumes().back().t_curr_);
-  q = math::Linterp(ini_.GetBoundaryTable().heat_right.q,
-                    mesh_.GetVolumes().back().t_curr_);
-  t_step = ini_.GetSolverSettings().solve_timestep;
-  bn = 2 * lambda * r * t_step * (1 - alfa[alfa.size() - 2]) +
-       cp * ro * dx * dx + 2 * a * dx * t_step;
-  mesh_.TCurr(mesh_.GetVolumes().size() - 1) =
-      2 * dx * t_step / bn *
-      (lambda * r * beta[beta.size() - 2] / dx + q + a * te +
-       ro * cp * dx * mesh_.GetVolumes().back().t_prev_step_ / 2 / t_step +
-       eps * math::SIGMA *
-           (pow(te, 4) - pow(mesh_.GetVolumes().back().t_prev_iter_, 4)));
+  mesh_.TCurr().back() =
+      RightBoundary(mesh_.TPrevIter().back(), alfa[alfa.size() - 2],
+                    beta[beta.size() - 2]);
 }
 
 void MainSolve::T() {
-  for (int i = mesh_.GetVolumes().size() - 2; i >= 0; --i) {
-    mesh_.TCurr(i) = alfa[i] * mesh_.GetVolumes()[i + 1].t_curr_ + beta[i];
+  std::span<double> t_curr = mesh_.TCurr();
+  for (int i = mesh_.Size() - 2; i >= 0; --i) {
+    t_curr[i] = alfa[i] * t_curr[i + 1] + beta[i];
   }
 }
 
 double MainSolve::Max() {
-  double max1 = abs(mesh_.GetVolumes().front().t_curr_ -
-                    mesh_.GetVolumes().front().t_curr_);
-  for (size_t i = 1; i < mesh_.GetVolumes().size(); ++i) {
-    if (max1 < abs(mesh_.GetVolumes()[i].t_curr_ -
-                   mesh_.GetVolumes()[i].t_prev_iter_)) {
-      max1 = abs(mesh_.GetVolumes()[i].t_curr_ -
-                 mesh_.GetVolumes()[i].t_prev_iter_);
+  std::span<const double> t_curr = mesh_.TCurr();
+  std::span<const double> t_prev_iter = mesh_.TPrevIter();
+  double max1 = abs(t_curr.front() - t_curr.front());
+  for (size_t i = 1; i < t_curr.size(); ++i) {
+    if (max1 < abs(t_curr[i] - t_prev_iter[i])) {
+      max1 = abs(t_curr[i] - t_prev_iter[i]);
     }
   }
-  double max2 = abs(mesh_.GetVolumes().front().t_curr_);
-  for (int i = 1; i < mesh_.GetVolumes().size(); ++i) {
-    if (max2 < abs(mesh_.GetVolumes()[i].t_curr_)) {
-      max2 = abs(mesh_.GetVolumes()[i].t_curr_);
+  double max2 = abs(t_curr.front());
+  for (int i = 1; i < t_curr.size(); ++i) {
+    if (max2 < abs(t_curr[i])) {
+      max2 = abs(t_curr[i]);
     }
   }
   return abs(max1 / max2);
 }
 
 double MainSolve::Max_1() {
-  double max = abs(mesh_.GetVolumes().front().t_curr_ -
-                   mesh_.GetVolumes().front().t_prev_iter_);
+  double max = abs(mesh_.TCurr().front() - mesh_.TPrevIter().front());
   return max;
 }
 
 double MainSolve::Max_N() {
-  double max = abs(mesh_.GetVolumes().back().t_curr_ -
-                   mesh_.GetVolumes().back().t_prev_iter_);
+  double max = abs(mesh_.TCurr().back() - mesh_.TPrevIter().back());
   return max;
 }
 
+IterNorms MainSolve::IterateSplit() {
+  dur_prevsteps_update_.Start();
+  mesh_.TPrevIterUpdate();
+  dur_prevsteps_update_.Stop();
+  ab_0();
+  dur_abi_.Start();
+  ab_i_impl();
+  dur_abi_.Stop();
+  T_N();
+  dur_t_calc_.Start();
+  T();
+  dur_t_calc_.Stop();
+  return {Max(), Max_1(), Max_N()};
+}
+
+// Same arithmetic as IterateSplit, but back-substitution and the convergence
+// norms share one backward pass over the mesh.
+IterNorms MainSolve::IterateFused() {
+  mesh_.TPrevIterUpdate();
+  dur_abi_.Start();
+  ab_0();
+  ab_i_impl();
+  T_N();
+  dur_abi_.Stop();
+  dur_t_calc_.Start();
+  std::span<double> t_curr = mesh_.TCurr();
+  std::span<const double> t_prev_iter = mesh_.TPrevIter();
+  size_t n = mesh_.Size() - 1;
+  double max_change = 0.0;
+  double max_abs = abs(t_curr[n]);
+  double change = abs(t_curr[n] - t_prev_iter[n]);
+  if (n > 0 && max_change < change) {
+    max_change = change;
+  }
+  for (size_t i = n; i-- > 0;) {
+    t_curr[i] = alfa[i] * t_curr[i + 1] + beta[i];
+    change = abs(t_curr[i] - t_prev_iter[i]);
+    if (i > 0 && max_change < change) {
+      max_change = change;
+    }
+    if (max_abs < abs(t_curr[i])) {
+      max_abs = abs(t_curr[i]);
+    }
+  }
+  dur_t_calc_.Stop();
+  return {abs(max_change / max_abs), change,
+          abs(t_curr[n] - t_prev_iter[n])};
+}
+
+// Solves the same system as IterateFused with the partitioned algorithm; the
+// norms are reduced per chunk.
+IterNorms MainSolve::IterateParallel() {
+  mesh_.TPrevIterUpdate();
+  std::span<double> t_curr = mesh_.TCurr();
+  std::span<const double> t_prev_iter = mesh_.TPrevIter();
+  size_t n = mesh_.Size() - 1;
+  dur_abi_.Start();
+  SweepStart start = LeftBoundary(t_prev_iter.front());
+  lower_.front() = 0.0;
+  diag_.front() = 1.0;
+  upper_.front() = -start.alfa;
+  rhs_.front() = start.beta;
+  BoundaryRow row = RightRow(t_prev_iter.back());
+  lower_.back() = row.lower;
+  diag_.back() = row.diag;
+  upper_.back() = 0.0;
+  rhs_.back() = row.rhs;
+  tdma_->Solve(lower_, diag_, upper_, rhs_, t_curr);
+  dur_abi_.Stop();
+
+  dur_t_calc_.Start();
+  size_t chunks = tdma_->Chunks();
+  std::vector<double> max_change(chunks, 0.0);
+  std::vector<double> max_abs(chunks, 0.0);
+  tdma_->Pool().ParallelFor(chunks, [&](size_t k) {
+    for (size_t i = std::max<size_t>(1, (n + 1) * k / chunks);
+         i < (n + 1) * (k + 1) / chunks; ++i) {
+      max_change[k] = std::max(max_change[k], abs(t_curr[i] - t_prev_iter[i]));
+      max_abs[k] = std::max(max_abs[k], abs(t_curr[i]));
+    }
+  });
+  double change = *std::max_element(max_change.begin(), max_change.end());
+  double t_max = std::max(abs(t_curr.front()),
+                          *std::max_element(max_abs.begin(), max_abs.end()));
+  dur_t_calc_.Stop();
+  return {abs(change / t_max), abs(t_curr.front() - t_prev_iter.front()),
+          abs(t_curr.back() - t_prev_iter.back())};
+}
+
+IterNorms MainSolve::Iterate() {
+  if (tdma_) {
+    return IterateParallel();
+  }
+  if (ini_.GetSolverSettings().fused_iteration) {
+    return IterateFused();
+  }
+  return IterateSplit();
+}
+
+bool MainSolve::Running() const {
+  return (ini_.GetSolverSettings().solve_time - time_) > EPS;
+}
+
+void MainSolve::BeginStep() {
+  prev_time_ = time_;
+  time_ += ini_.GetSolverSettings().solve_timestep;
+  ++step_;
+  if (schedule_) {
+    schedule_->Seek(step_);
+  }
+  log_.Time(time_);
+  dur_prevsteps_update_.Start();
+  mesh_.TPrevStepUpdate();
+  dur_prevsteps_update_.Stop();
+  dur_volumeprops_update_.Start();
+  mesh_.UpdateVolumeProps();
+  dur_volumeprops_update_.Stop();
+  log_.PropsSkipped(mesh_.SkippedVolumes(), mesh_.Size());
+  dur_abi_.Start();
+  AssembleCoefficients();
+  dur_abi_.Stop();
+  iter = 0;
+}
+
+void MainSolve::EndStep() {
+  // if (times_output.front() > prev_time && times_output.front() <= time) {
+  //   AddResults(prev_time, times_output.front(), time);
+  //   times_output.pop_front();
+  // }
+  dur_res_write_.Start();
+  if (out_time_ > prev_time_ && out_time_ <= time_) {
+    AddResults(prev_time_, out_time_, time_);
+    out_time_ += ini_.GetSolverSettings().output_timestep;
+  }
+  dur_res_write_.Stop();
+}
+
+void MainSolve::LogIteration(size_t iter, const IterNorms& norms) {
+  log_.SimpleIter(iter, norms.max, norms.max_1, norms.max_N, mesh_);
+}
+
 void MainSolve::solve_impl(bool logging) {
-  double max, max_1, max_N, time = 0.0, prev_time = 0.0;
-  while ((ini_.GetSolverSettings().solve_time - time) > EPS) {
-    prev_time = time;
-    time += ini_.GetSolverSettings().solve_timestep;
-    log_.Time(time);
-    dur_prevsteps_update.Start();
-    mesh_.TPrevStepUpdate();
-    dur_prevsteps_update.Stop();
-    dur_volumeprops_update.Start();
-    mesh_.UpdateVolumeProps();
-    dur_volumeprops_update.Stop();
-    iter = 0;
+  IterNorms norms;
+  while (Running()) {
+    BeginStep();
     do {
       ++iter;
-      dur_prevsteps_update.Start();
-      mesh_.TPrevIterUpdate();
-      dur_prevsteps_update.Stop();
-      ab_0();
-      dur_abi.Start();
-      ab_i_impl();
-      dur_abi.Stop();
-      T_N();
-      dur_t_calc.Start();
-      T();
-      dur_t_calc.Stop();
-      max = Max();
-      max_1 = Max_1();
-      max_N = Max_N();
-      log_.SimpleIter(iter, max, max_1, max_N, mesh_);
-    } while (max >= EPS_ITER || max_1 >= EPS_ITER || max_N >= EPS_ITER);
-    // if (times_output.front() > prev_time && times_output.front() <= time) {
-    //   AddResults(prev_time, times_output.front(), time);
-    //   times_output.pop_front();
-    // }
-    dur_res_write.Start();
-    if (out_time_ > prev_time && out_time_ <= time) {
-      AddResults(prev_time, out_time_, time);
-      out_time_ += ini_.GetSolverSettings().output_timestep;
-    }
-    dur_res_write.Stop();
+      norms = Iterate();
+      LogIteration(iter, norms);
+    } while (norms.max >= EPS_ITER || norms.max_1 >= EPS_ITER ||
+             norms.max_N >= EPS_ITER);
+    EndStep();
   }
 }
 
+void MainSolve::StreamResults(std::shared_ptr<ResultsWriter> writer) {
+  writer_ = std::move(writer);
+  writer_->Open(ini_, res_);
+}
+
 void MainSolve::AddResults(double prev_time, double time, double curr_time) {
-  res_.time.push_back(time);
-  res_.bound_temp_distr.push_back({});
-  TempCoord temp_coord;
-  for (const Volume& vol : mesh_.GetVolumes()) {
-    temp_coord.x.push_back(vol.x_);
-    temp_coord.temp.push_back(math::Linterp(
-        prev_time, curr_time, vol.t_prev_step_, vol.t_curr_, time));
-    if (vol.mat_left_ != vol.mat_right_) {
-      res_.bound_temp_distr.back().push_back(math::Linterp(
-          prev_time, curr_time, vol.t_prev_step_, vol.t_curr_, time));
-    }
+  std::span<const double> t_prev_step = mesh_.TPrevStep();
+  std::span<const double> t_curr = mesh_.TCurr();
+  std::span<double> row = writer_ ? writer_->Acquire(time) : res_.AddRow(time);
+  for (size_t i = 0; i < row.size(); ++i) {
+    row[i] = math::Linterp(prev_time, curr_time, t_prev_step[i], t_curr[i],
+                           time);
+  }
+  if (writer_) {
+    writer_->Publish();
   }
-  res_.temp_coord_distr.push_back(std::move(temp_coord));
 }
 
 // void MainSolve::AddResults(double time) {
@@ -70,12 +70,47 @@
 
 #pragma once
 #include <deque>
+#include <memory>
 
 #include "ini_data.h"
+#include "log_duration.h"
 #include "logger.h"
 #include "mesh.h"
+#include "results_writer.h"
+#include "schedule.h"
+#include "tridiag.h"
+
+// Convergence norms of one Picard iteration: relative max change over the
+// mesh and absolute changes at the left and right walls.
+struct IterNorms {
+  double max;
+  double max_1;
+  double max_N;
+};
+
+// First row of the sweep produced by the left boundary condition.
+struct SweepStart {
+  double alfa;
+  double beta;
+};
+
+// Last row of the system: lower * T[N - 1] + diag * T[N] = rhs.
+struct BoundaryRow {
+  double lower;
+  double diag;
+  double rhs;
+};
 
 class MainSolve {
+  // Per-step terms of a boundary volume: control volume width, lambda_eff * r,
+  // ro * cp * dx^2 and the heat stored at the previous step.
+  struct BoundaryTerms {
+    double dx;
+    double lr;
+    double rocp_dx2;
+    double storage;
+  };
+
   Mesh& mesh_;
   const IniData& ini_;
   Logger& log_;
@@ -86,14 +121,48 @@ class MainSolve {
   std::vector<double> B;
   std::vector<double> C;
   std::vector<double> F;
-  double lambda, lambda_l, lambda_r, ro, cp, dx, t_step, a, te, eps, trad, q;
+  // Row form of the system for the partitioned solver, used on meshes above
+  // the parallel threshold.
+  std::unique_ptr<tridiag::Partitioned> tdma_;
+  std::vector<double> lower_;
+  std::vector<double> diag_;
+  std::vector<double> upper_;
+  std::vector<double> rhs_;
+  BoundaryTerms left_;
+  BoundaryTerms right_;
+  // The compiled boundary tables are looked up at the wall temperature on
+  // every iteration, so each keeps the segment of its previous lookup.
+  mutable math::SegmentCursor left_cursor_;
+  mutable math::SegmentCursor right_cursor_;
+  // Set when the boundary tables are a time schedule; indexed by step_.
+  std::shared_ptr<BoundarySchedule> schedule_;
+  // Set when the snapshots go to a file during the run instead of res_.
+  std::shared_ptr<ResultsWriter> writer_;
+  size_t step_ = 0;
+  double t_step;
+  double time_ = 0.0;
+  double prev_time_ = 0.0;
   size_t iter = 0;
   std::deque<double> times_output;
   double out_time_;
   std::stringstream log;
+  // Phase timers of this solver, added to the process-wide ones when it is
+  // destroyed, so that solvers on several threads share nothing per step.
+  LocalDuration dur_res_write_;
+  LocalDuration dur_prevsteps_update_;
+  LocalDuration dur_volumeprops_update_;
+  LocalDuration dur_abi_;
+  LocalDuration dur_t_calc_;
 
  public:
   MainSolve(Mesh& mesh, const IniData& ini, Results& res, Logger& log);
+  ~MainSolve();
+  void AssembleCoefficients();
+  IniData::HeatValues LeftHeat(double t_wall) const;
+  IniData::HeatValues RightHeat(double t_wall) const;
+  SweepStart LeftBoundary(double t_wall) const;
+  BoundaryRow RightRow(double t_wall) const;
+  double RightBoundary(double t_wall, double alfa_prev, double beta_prev) const;
   void ab_0();
   void ab_i_impl();
   void T_N();
@@ -101,7 +170,37 @@ class MainSolve {
   double Max_1();
   double Max_N();
   double Max();
+  IterNorms IterateSplit();
+  IterNorms IterateFused();
+  IterNorms IterateParallel();
+  IterNorms Iterate();
+
+  bool Running() const;
+  void BeginStep();
+  void EndStep();
+  void LogIteration(size_t iter, const IterNorms& norms);
+
+  Mesh& GetMesh() { return mesh_; }
+  const std::shared_ptr<BoundarySchedule>& Schedule() const {
+    return schedule_;
+  }
+  // Replaces the own schedule with one sampled from the same tables, so that
+  // cases of a batch read a single array.
+  void ShareSchedule(std::shared_ptr<BoundarySchedule> schedule) {
+    schedule_ = std::move(schedule);
+  }
+  // Hands the snapshots to an open writer from now on; res_ keeps only the
+  // coordinates and interfaces and never reserves its rows.
+  void StreamResults(std::shared_ptr<ResultsWriter> writer);
+  const IniData& GetIniData() const { return ini_; }
+  std::span<const double> CoefA() const { return A; }
+  std::span<const double> CoefB() const { return B; }
+  std::span<const double> CoefC() const { return C; }
+  std::span<const double> CoefF() const { return F; }
+
   void solve_impl(bool logging = 0);
   void Print(std::ostream& out) const;
   void AddResults(double prev_time, double time, double curr_time);
+  // Snapshots a full run adds.
+  size_t OutputCount() const;
 };
\ No newline at end of file
@@ -0,0 +1,71 @@
+#include "stations.h"
+
+#include <filesystem>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+#include "boundary_gen.h"
+#include "thread_pool.h"
+
+StationSolve::StationSolve(const std::string& name, bool logging) {
+  std::ifstream fin(name + ".json");
+  ordered_json json = ordered_json::parse(fin);
+  if (!json.contains("stations") || json.at("stations").empty()) {
+    throw std::logic_error(name + ": no stations");
+  }
+  threads_ = json.value("threads", std::size_t{0});
+  if (threads_ == 0) {
+    threads_ = std::thread::hardware_concurrency();
+  }
+  ordered_json common = json;
+  common.erase("stations");
+  common["threads"] = 1;
+  stations_.resize(json.at("stations").size());
+  for (size_t i = 0; i < stations_.size(); ++i) {
+    ordered_json merged = common;
+    for (const auto& [key, value] : json.at("stations")[i].items()) {
+      merged[key] = value;
+    }
+    Station& station = stations_[i];
+    std::stringstream ss(merged.dump());
+    station.ini = std::make_unique<IniData>(ss);
+    if (!base_) {
+      base_ = std::make_unique<base::Database>(*station.ini);
+    } else {
+      base_->Add(*station.ini);
+    }
+    // Named by index, as stations need not have distinct names.
+    std::filesystem::path log_name(name);
+    log_name.replace_filename("LOG_" + log_name.filename().string() + "_" +
+                              std::to_string(i) + ".txt");
+    station.log = std::make_unique<Logger>(log_name.string(), logging);
+  }
+}
+
+// Meshes and solvers are built inside the tasks, so that setting up the
+// stations is spread over the pool as well.
+void StationSolve::solve_impl() {
+  ThreadPool pool(std::min(threads_, stations_.size()));
+  pool.ParallelFor(stations_.size(), [&](size_t i) {
+    Station& station = stations_[i];
+    heat_exchange::PrepareBoundary(
+        *station.ini,
+        base_->GetFuel(station.ini->GetDomainSettings().fuel_name));
+    station.mesh = std::make_unique<Mesh>(*base_, *station.ini);
+    station.solver = std::make_unique<MainSolve>(*station.mesh, *station.ini,
+                                                 station.res, *station.log);
+    station.solver->solve_impl();
+  });
+}
+
+void StationSolve::Print(std::ostream& os) const {
+  for (size_t i = 0; i < stations_.size(); ++i) {
+    const Station& station = stations_[i];
+    os << "Station " << i << ": " << station.ini->GetDomainSettings().name
+       << '\n';
+    station.res.PrintBoundsDistr(os, *station.ini);
+    station.res.PrintXDistr(os);
+    os << '\n';
+  }
+}
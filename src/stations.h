@@ -0,0 +1,41 @@
+#pragma once
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "data_base.h"
+#include "ini_data.h"
+#include "logger.h"
+#include "mesh.h"
+#include "solver.h"
+
+// Solves the wall cross-sections of one nozzle, listed in a single ini. Each
+// entry of its "stations" array is an object whose keys replace the top-level
+// ones, e.g. the name, radii, flow type and layup of one section. The stations
+// share one Database and run independently on a thread pool of the top-level
+// "threads" size; each station solves on one thread unless it sets its own
+// "threads".
+class StationSolve {
+ private:
+  struct Station {
+    std::unique_ptr<IniData> ini;
+    std::unique_ptr<Mesh> mesh;
+    std::unique_ptr<Logger> log;
+    std::unique_ptr<MainSolve> solver;
+    Results res;
+  };
+  std::unique_ptr<base::Database> base_;
+  std::vector<Station> stations_;
+  size_t threads_;
+
+ public:
+  explicit StationSolve(const std::string& name, bool logging = false);
+  void solve_impl();
+  size_t Size() const { return stations_.size(); }
+  const IniData& GetIniData(size_t i) const { return *stations_[i].ini; }
+  const Results& GetResults(size_t i) const { return stations_[i].res; }
+  // Results of all stations in one output, in ini order, each under a
+  // "Station <index>: <name>" header.
+  void Print(std::ostream& os) const;
+};
@@ -0,0 +1,190 @@
+#pragma once
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <sstream>
+#include <thread>
+
+#include "batch_solver.h"
+#include "data_base.h"
+#include "log_duration.h"
+#include "logger.h"
+#include "mesh.h"
+#include "solver.h"
+#include "stations.h"
+#include "test_case.h"
+
+void TestBatchSolver() {
+  IniData ini("ini_data");
+  base::Database base(ini);
+  size_t count = BatchSolve::LANES + 1;
+  std::vector<std::unique_ptr<Mesh>> meshes;
+  std::vector<Results> single(count);
+  std::vector<Results> batch(count);
+  std::vector<std::unique_ptr<Logger>> logs;
+  std::vector<std::unique_ptr<MainSolve>> solvers;
+  std::vector<MainSolve*> cases;
+  LogDuration dur_single("Single cases");
+  LogDuration dur_batch("Batch");
+  auto pool = std::make_shared<ThreadPool>(std::thread::hardware_concurrency());
+  for (size_t i = 0; i < count; ++i) {
+    IniData::InitialState state = ini.GetInitialState();
+    state.t_initial = {{0.0, 273.0 + 10.0 * i}};
+    logs.push_back(std::make_unique<Logger>("LOG_batch.txt", 0));
+    meshes.push_back(std::make_unique<Mesh>(base, ini, pool));
+    meshes.back()->InitializeMesh(ini.GetDomainSettings(), state);
+    MainSolve solver(*meshes.back(), ini, single[i], *logs.back());
+    dur_single.Start();
+    solver.solve_impl();
+    dur_single.Stop();
+    meshes.back()->InitializeMesh(ini.GetDomainSettings(), state);
+    solvers.push_back(std::make_unique<MainSolve>(*meshes.back(), ini,
+                                                  batch[i], *logs.back()));
+    cases.push_back(solvers.back().get());
+  }
+  dur_batch.Start();
+  BatchSolve(cases).solve_impl();
+  dur_batch.Stop();
+  for (size_t i = 0; i < count; ++i) {
+    assert(single[i].time == batch[i].time);
+    for (size_t k = 0; k < single[i].temp.size(); ++k) {
+      assert(std::abs(single[i].temp[k] - batch[i].temp[k]) < 1E-9);
+    }
+  }
+  std::cout << "TestBatchSolver are OK" << std::endl;
+}
+
+// Databases built from one IniData, or on several threads, borrow the same
+// tables; one material at two angles or two grid steps gives two entries.
+void TestSharedDatabase() {
+  IniData ini("ini_data");
+  const IniData::Domain& domain = ini.GetDomainSettings();
+  double step = ini.GetSolverSettings().material_grid_step;
+  base::Database first(ini);
+  std::vector<std::unique_ptr<base::Database>> others(4);
+  std::vector<std::thread> threads;
+  for (auto& other : others) {
+    threads.emplace_back([&] { other = std::make_unique<base::Database>(ini); });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  for (const auto& other : others) {
+    assert(&other->GetFuel(domain.fuel_name) == &first.GetFuel(domain.fuel_name));
+    for (size_t i = 0; i < domain.mat_names.size(); ++i) {
+      assert(&other->GetMaterial(domain.mat_names[i], domain.angles[i],
+                                 step) ==
+             &first.GetMaterial(domain.mat_names[i], domain.angles[i], step));
+    }
+  }
+  base::Registry& registry = base::Registry::Instance();
+  auto along = registry.GetMaterial(domain.mat_names.front(), 0.0, step);
+  auto across = registry.GetMaterial(domain.mat_names.front(), 90.0, step);
+  assert(along != across);
+  assert(along->GetProperty(1000.0, material::Property::l) ==
+         along->GetProperty(1000.0, material::Property::l0));
+  assert(across->GetProperty(1000.0, material::Property::l) ==
+         across->GetProperty(1000.0, material::Property::l90));
+
+  // A later case with another grid step gets its own grids.
+  TestDir dir("shared_database");
+  IniData fine(dir.Ini("ini_fine", {{"material grid step", step / 2}}));
+  first.Add(fine);
+  const std::string& name = domain.mat_names.front();
+  double angle = domain.angles.front();
+  assert(&first.GetMaterial(name, angle, step / 2) ==
+         registry.GetMaterial(name, angle, step / 2).get());
+  assert(&first.GetMaterial(name, angle, step) ==
+         registry.GetMaterial(name, angle, step).get());
+  assert(&first.GetMaterial(name, angle, step / 2) !=
+         &first.GetMaterial(name, angle, step));
+  std::cout << "TestSharedDatabase are OK" << std::endl;
+}
+
+// Stations of one ini solved on a pool must match the same stations solved
+// one at a time, and the first one must match a plain MainSolve of its ini.
+void TestStations() {
+  TestDir dir("stations");
+  ordered_json base_ini = TestDir::BaseIni();
+  ordered_json patch = {{"stations", ordered_json::array()}, {"threads", 1}};
+  for (size_t i = 0; i < 8; ++i) {
+    ordered_json station = {{"name", "station " + std::to_string(i)},
+                            {"initial radius", 0.1 + 0.05 * i}};
+    std::vector<double> thickness = base_ini.at("thickness");
+    for (double& t : thickness) {
+      t *= 1.0 + 0.1 * i;
+    }
+    station["thickness"] = thickness;
+    patch["stations"].push_back(station);
+  }
+  std::string serial_ini = dir.Ini("ini_stations_serial", patch);
+  patch["threads"] = 0;
+  std::string parallel_ini = dir.Ini("ini_stations", patch);
+
+  using Clock = std::chrono::steady_clock;
+  StationSolve serial(serial_ini);
+  auto start = Clock::now();
+  serial.solve_impl();
+  std::chrono::duration<double, std::milli> one = Clock::now() - start;
+  StationSolve parallel(parallel_ini);
+  start = Clock::now();
+  parallel.solve_impl();
+  std::chrono::duration<double, std::milli> many = Clock::now() - start;
+
+  std::stringstream lhs;
+  std::stringstream rhs;
+  serial.Print(lhs);
+  parallel.Print(rhs);
+  assert(lhs.str() == rhs.str());
+  assert(rhs.str().find("Station 7: station 7") != std::string::npos);
+
+  const IniData& ini = parallel.GetIniData(0);
+  base::Database base(ini);
+  Mesh mesh(base, ini);
+  Results res;
+  Logger log(dir.Path("LOG_station.txt"), 0);
+  MainSolve(mesh, ini, res, log).solve_impl();
+  std::stringstream single;
+  std::stringstream first;
+  res.PrintXDistr(single);
+  parallel.GetResults(0).PrintXDistr(first);
+  assert(single.str() == first.str());
+  std::cout << "Stations, " << parallel.Size() << ": one thread "
+            << one.count() << " ms, " << std::thread::hardware_concurrency()
+            << " threads " << many.count() << " ms" << std::endl;
+  std::cout << "TestStations are OK" << std::endl;
+}
+
+// A station that fails to set up must fail the run with its exception, on the
+// calling thread, after the other stations are solved.
+void TestStationError() {
+  TestDir dir("station_error");
+  // The pressure is given per station; null removes it from the common part.
+  ordered_json pressure = TestDir::BaseIni().at("pressure");
+  ordered_json patch = {{"stations", ordered_json::array()},
+                        {"pressure", nullptr},
+                        {"threads", 4}};
+  for (size_t i = 0; i < 4; ++i) {
+    patch["stations"].push_back(
+        {{"initial radius", 0.1 + 0.05 * i}, {"pressure", pressure}});
+  }
+  // Boundary generation without a pressure throws in PrepareBoundary.
+  patch["stations"][2] = {{"generate boundary", true}};
+  for (size_t threads : {1, 4}) {
+    patch["threads"] = threads;
+    StationSolve stations(
+        dir.Ini("ini_stations_" + std::to_string(threads), patch));
+    bool thrown = false;
+    try {
+      stations.solve_impl();
+    } catch (const std::logic_error&) {
+      thrown = true;
+    }
+    assert(thrown);
+    for (size_t i : {0, 1, 3}) {
+      assert(stations.GetResults(i).Rows() > 0);
+    }
+  }
+  std::cout << "TestStationError are OK" << std::endl;
+}
@@ -0,0 +1,77 @@
+#pragma once
+#include <unistd.h>
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include "boundary_gen.h"
+#include "data_base.h"
+#include "ini_data.h"
+#include "logger.h"
+#include "mesh.h"
+#include "solver.h"
+
+// Scratch directory of one test under the system temp directory, removed with
+// the object. Materials and fuels are still read from the working directory.
+class TestDir {
+ private:
+  std::filesystem::path dir_;
+
+ public:
+  explicit TestDir(const std::string& name)
+      : dir_(std::filesystem::temp_directory_path() /
+             ("1dheat_" + name + "_" + std::to_string(getpid()))) {
+    std::filesystem::remove_all(dir_);
+    std::filesystem::create_directories(dir_);
+  }
+  TestDir(const TestDir&) = delete;
+  TestDir& operator=(const TestDir&) = delete;
+  ~TestDir() {
+    std::error_code ec;
+    std::filesystem::remove_all(dir_, ec);
+  }
+
+  std::string Path(const std::string& file) const {
+    return (dir_ / file).string();
+  }
+  // The reference case, ini_data.json of the working directory.
+  static ordered_json BaseIni() {
+    std::ifstream fin("ini_data.json");
+    return ordered_json::parse(fin);
+  }
+  // The reference case with patch merged in (RFC 7396: objects key by key,
+  // anything else replaced), written as <name>.json. Returns the name to pass
+  // to IniData or StationSolve.
+  std::string Ini(const std::string& name, const ordered_json& patch) const {
+    ordered_json json = BaseIni();
+    json.merge_patch(patch);
+    std::ofstream(Path(name + ".json")) << json.dump(4);
+    return Path(name);
+  }
+};
+
+// One case of a test: the reference case with a patch, on its own mesh, with
+// its log in the test directory. Generated boundaries are prepared here, as
+// StationSolve does.
+struct TestRun {
+  IniData ini;
+  base::Database base;
+  Mesh mesh;
+  Logger log;
+  Results res;
+
+  TestRun(const TestDir& dir, const std::string& name,
+          const ordered_json& patch = ordered_json::object())
+      : ini(dir.Ini(name, patch)),
+        base(ini),
+        mesh(base, ini),
+        log(dir.Path("LOG_" + name + ".txt"), 0) {
+    heat_exchange::PrepareBoundary(
+        ini, base.GetFuel(ini.GetDomainSettings().fuel_name));
+  }
+  TestRun(const TestRun&) = delete;
+  TestRun& operator=(const TestRun&) = delete;
+
+  void Solve() { MainSolve(mesh, ini, res, log).solve_impl(); }
+};
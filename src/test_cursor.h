@@ -0,0 +1,132 @@
+#pragma once
+#include <cassert>
+#include <chrono>
+#include <iostream>
+
+#include "data_base.h"
+#include "fuel.h"
+#include "logger.h"
+#include "material.h"
+#include "mesh.h"
+#include "solver.h"
+
+// Replays the temperature and pressure histories of a real transient through
+// the table lookups, once with a fresh binary search per call and once with a
+// cursor per history.
+void TestLinterpCursor() {
+  IniData ini("ini_data");
+  base::Database base(ini);
+  Mesh mesh(base, ini);
+  Results res;
+  Logger log("LOG_cursor.txt", 0);
+  MainSolve solver(mesh, ini, res, log);
+  std::vector<std::vector<double>> t_history(mesh.Size());
+  std::vector<double> p_history;
+  double time = 0.0;
+  while (solver.Running()) {
+    solver.BeginStep();
+    IterNorms norms;
+    do {
+      norms = solver.Iterate();
+    } while (norms.max >= EPS_ITER || norms.max_1 >= EPS_ITER ||
+             norms.max_N >= EPS_ITER);
+    solver.EndStep();
+    time += ini.GetSolverSettings().solve_timestep;
+    for (size_t i = 0; i < mesh.Size(); ++i) {
+      t_history[i].push_back(mesh.TCurr()[i]);
+    }
+    p_history.push_back(math::Linterp(*ini.GetInitialState().pressure, time));
+  }
+
+  const IniData::Domain& domain = ini.GetDomainSettings();
+  std::vector<material::Material> mats;
+  std::vector<size_t> layer(mesh.Size(), 0);
+  for (size_t l = 0, i = 0; l < domain.layers_count; ++l) {
+    mats.emplace_back(domain.mat_names[l], domain.angles[l], 0.0);
+    for (uint j = 0; j < domain.subdivisions[l]; ++j) {
+      layer[++i] = l;
+    }
+  }
+
+  using Clock = std::chrono::steady_clock;
+  int repeats = 20;
+  double sum = 0.0;
+  auto start = Clock::now();
+  for (int r = 0; r < repeats; ++r) {
+    for (size_t i = 0; i < mesh.Size(); ++i) {
+      for (double t : t_history[i]) {
+        sum += mats[layer[i]].GetProperty(t, material::Property::cp);
+      }
+    }
+  }
+  std::chrono::duration<double, std::milli> plain = Clock::now() - start;
+  double sum_cursor = 0.0;
+  size_t calls = 0;
+  size_t hits = 0;
+  start = Clock::now();
+  for (int r = 0; r < repeats; ++r) {
+    for (size_t i = 0; i < mesh.Size(); ++i) {
+      math::SegmentCursor cursor;
+      for (double t : t_history[i]) {
+        sum_cursor +=
+            mats[layer[i]].GetProperty(t, material::Property::cp, cursor);
+      }
+      calls += cursor.Calls();
+      hits += cursor.Hits();
+    }
+  }
+  std::chrono::duration<double, std::milli> cached = Clock::now() - start;
+  assert(sum == sum_cursor);
+  std::cout << "Material cp tables: hit rate "
+            << static_cast<double>(hits) / calls << ", "
+            << plain.count() / repeats << " ms -> "
+            << cached.count() / repeats << " ms" << std::endl;
+
+  material::Thermal props = mats.front().GetProps();
+  const std::map<double, double>& cp = props.at(material::Property::cp);
+  sum = 0.0;
+  start = Clock::now();
+  for (int r = 0; r < repeats; ++r) {
+    for (double t : t_history.front()) {
+      sum += math::Linterp(cp, t);
+    }
+  }
+  plain = Clock::now() - start;
+  sum_cursor = 0.0;
+  math::Cursor<double, double> wall;
+  start = Clock::now();
+  for (int r = 0; r < repeats; ++r) {
+    for (double t : t_history.front()) {
+      sum_cursor += math::Linterp(cp, t, wall);
+    }
+  }
+  cached = Clock::now() - start;
+  assert(sum == sum_cursor);
+  std::cout << "Wall table map: hit rate " << wall.HitRate() << ", "
+            << plain.count() / repeats << " ms -> "
+            << cached.count() / repeats << " ms" << std::endl;
+
+  const fuel::Fuel& fuel = base.GetFuel(domain.fuel_name);
+  sum = 0.0;
+  start = Clock::now();
+  for (int r = 0; r < repeats; ++r) {
+    for (double p : p_history) {
+      sum += fuel.GetTotalTemp(p);
+    }
+  }
+  plain = Clock::now() - start;
+  sum_cursor = 0.0;
+  math::Cursor<double, double> total_temp;
+  start = Clock::now();
+  for (int r = 0; r < repeats; ++r) {
+    for (double p : p_history) {
+      sum_cursor += fuel.GetTotalTemp(p, total_temp);
+    }
+  }
+  cached = Clock::now() - start;
+  assert(sum == sum_cursor);
+  std::cout << "Fuel total temperature: hit rate " << total_temp.HitRate()
+            << ", " << plain.count() / repeats << " ms -> "
+            << cached.count() / repeats << " ms" << std::endl;
+  std::cout << "TestLinterpCursor are OK" << std::endl;
+}
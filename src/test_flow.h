@@ -0,0 +1,168 @@
+#pragma once
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+#include "boundary_cond.h"
+#include "data_base.h"
+#include "flow.h"
+
+// Fixed-point iteration that Flow1D::CalcLambda used before the Halley solver;
+// the baseline for the timing.
+double FixedPointLambda(double ksi, double k, flow::FlowType flow_type) {
+  double n = 1 / (k - 1.0);
+  double k1 = k + 1.0;
+  double k2 = k - 1.0;
+  double lambda = 1.0;
+  double prev_value;
+  int iters = 0;
+  do {
+    prev_value = lambda;
+    if (flow_type == flow::FlowType::subsonic) {
+      lambda = 1.0 / (pow(k1 / 2.0, n) *
+                      pow(1.0 - prev_value * prev_value * k2 / k1, n) * ksi *
+                      ksi);
+    } else {
+      lambda = k1 / k2 / prev_value -
+               2 / pow(prev_value, k) / k2 / pow(ksi, 2 * k - 2);
+    }
+  } while (std::abs(lambda - prev_value) > 0.00001 && ++iters < 10000);
+  return lambda;
+}
+
+double GasDynamicQ(double lambda, double k) {
+  return lambda * std::pow((k + 1.0) / 2.0, 1.0 / (k - 1.0)) *
+         std::pow(1.0 - (k - 1.0) / (k + 1.0) * lambda * lambda,
+                  1.0 / (k - 1.0));
+}
+
+// Inverts q(lambda) over radius ratios 1..10 and the k range of the fuel on
+// both branches: without a guess, from the table and by the old iteration.
+void TestLambdaSolver() {
+  base::Database base("ini_data");
+  const fuel::Fuel& fuel = base.GetFuel("nikag");
+  flow::LambdaTable table(1.1, 1.3);
+  std::vector<double> ksis;
+  for (double ksi = 1.0005; ksi < 10.0; ksi *= 1.002) {
+    ksis.push_back(ksi);
+  }
+  std::vector<double> ks;
+  for (double k = 1.1; k <= 1.3; k += 0.01) {
+    ks.push_back(k);
+  }
+  using Clock = std::chrono::steady_clock;
+  for (flow::FlowType type :
+       {flow::FlowType::subsonic, flow::FlowType::supersonic}) {
+    const char* name =
+        type == flow::FlowType::subsonic ? "subsonic" : "supersonic";
+    long plain_iters = 0;
+    long table_iters = 0;
+    for (double k : ks) {
+      for (double ksi : ksis) {
+        int iters;
+        double plain = flow::SolveLambda(ksi, k, type, 0.0, &iters);
+        plain_iters += iters;
+        double guess = table.Guess(ksi, k, type);
+        double tabled = flow::SolveLambda(ksi, k, type, guess, &iters);
+        table_iters += iters;
+        assert(iters <= 3);
+        assert(std::abs(tabled - plain) <= 1E-11 * plain);
+        assert(std::abs(GasDynamicQ(plain, k) * ksi * ksi - 1.0) <= 1E-10);
+        assert((plain < 1.0) == (type == flow::FlowType::subsonic));
+      }
+    }
+
+    double sum_old = 0.0;
+    auto start = Clock::now();
+    for (double k : ks) {
+      for (double ksi : ksis) {
+        sum_old += FixedPointLambda(ksi, k, type);
+      }
+    }
+    std::chrono::duration<double, std::milli> old = Clock::now() - start;
+    double sum_plain = 0.0;
+    start = Clock::now();
+    for (double k : ks) {
+      for (double ksi : ksis) {
+        sum_plain += flow::SolveLambda(ksi, k, type);
+      }
+    }
+    std::chrono::duration<double, std::milli> plain = Clock::now() - start;
+    double sum_table = 0.0;
+    start = Clock::now();
+    for (double k : ks) {
+      for (double ksi : ksis) {
+        sum_table += flow::SolveLambda(ksi, k, type, table.Guess(ksi, k, type));
+      }
+    }
+    std::chrono::duration<double, std::milli> tabled = Clock::now() - start;
+    size_t count = ks.size() * ksis.size();
+    std::cout << "lambda " << name << ", " << count
+              << " solves: fixed point " << old.count() << " ms (sum "
+              << sum_old << "), Halley " << plain.count() << " ms ("
+              << static_cast<double>(plain_iters) / count
+              << " iterations), with table " << tabled.count() << " ms ("
+              << static_cast<double>(table_iters) / count << " iterations)"
+              << std::endl;
+    assert(std::abs(sum_plain - sum_table) <= 1E-9 * sum_plain);
+  }
+
+  flow::Flow1D flow(fuel);
+  flow::Flow1D flow_table(fuel, true);
+  for (double ksi : {1.0, 1.5, 3.0}) {
+    for (flow::FlowType type :
+         {flow::FlowType::subsonic, flow::FlowType::supersonic}) {
+      flow::FlowParams lhs = flow.GetParams(5E6, ksi, type);
+      flow::FlowParams rhs = flow_table.GetParams(5E6, ksi, type);
+      assert(std::abs(lhs.lambda - rhs.lambda) <= 1E-11 * lhs.lambda);
+      assert(std::abs(lhs.lambda - FixedPointLambda(ksi, lhs.k, type)) < 1E-4);
+    }
+  }
+  std::cout << "TestLambdaSolver are OK" << std::endl;
+}
+
+// Boundary table for a firing history: the batch must match the scalar call,
+// and a pressure plateau must solve the gas dynamics once.
+void TestHeatExchangeBatch() {
+  IniData ini("ini_data");
+  base::Database base(ini);
+  const fuel::Fuel& fuel = base.GetFuel(ini.GetDomainSettings().fuel_name);
+  const std::map<double, double>& pressure = *ini.GetInitialState().pressure;
+  double t_end = pressure.rbegin()->first;
+  std::vector<heat_exchange::IniDataAvd> history;
+  for (size_t i = 0; i < 20000; ++i) {
+    double p = math::Linterp(pressure, t_end * i / 20000);
+    history.push_back({p, 0.02, 0.05, 0.1, flow::FlowType::subsonic});
+    history.push_back({p, 0.02, 0.06, 0.1, flow::FlowType::supersonic});
+  }
+  flow::Flow1D flow(fuel, true);
+  heat_exchange::HeatExchange batch(fuel, flow);
+  std::vector<heat_exchange::Result> res(history.size());
+  using Clock = std::chrono::steady_clock;
+  auto start = Clock::now();
+  batch.CalcAvd(history, res);
+  std::chrono::duration<double, std::milli> first = Clock::now() - start;
+  size_t solves = batch.FlowSolves();
+  heat_exchange::IniDataAvd steady{5E6, 0.02, 0.05, 0.1,
+                                   flow::FlowType::subsonic};
+  std::vector<heat_exchange::IniDataAvd> plateau(1000, steady);
+  std::vector<heat_exchange::Result> res_plateau(plateau.size());
+  batch.CalcAvd(plateau, res_plateau);
+  assert(batch.FlowSolves() == solves + 1);
+
+  heat_exchange::HeatExchange single(fuel, flow);
+  start = Clock::now();
+  for (size_t i = 0; i < history.size(); ++i) {
+    heat_exchange::Result r =
+        single.Calc(history[i], heat_exchange::CalcType::avd);
+    assert(r.alfa == res[i].alfa && r.t_e == res[i].t_e &&
+           r.t_rad == res[i].t_rad && r.eps_gas == res[i].eps_gas);
+  }
+  std::chrono::duration<double, std::milli> scalar = Clock::now() - start;
+  std::cout << "Heat exchange, " << history.size() << " instants, "
+            << solves << " flow solves: batch " << first.count()
+            << " ms, one by one " << scalar.count() << " ms" << std::endl;
+  std::cout << "TestHeatExchangeBatch are OK" << std::endl;
+}
@@ -0,0 +1,149 @@
+#pragma once
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+#include "data_base.h"
+#include "fuel.h"
+#include "test_case.h"
+
+// Bilinear lookup on the nested tables, as Fuel::GetProperties did before the
+// grid: the reference for the grid and the baseline for its timing.
+fuel::PropTable MapProperties(const fuel::Properties& tables, double p,
+                              double t) {
+  auto p_b = math::GetParamBounds(tables, p);
+  auto t1_b = math::GetParamBounds(p_b.first->second, t);
+  auto t2_b = math::GetParamBounds(p_b.second->second, t);
+  fuel::PropTable res;
+  for (int i = fuel::FuelProp::v; i < fuel::FuelProp::null; ++i) {
+    fuel::FuelProp prop = static_cast<fuel::FuelProp>(i);
+    double param1 =
+        math::Linterp(t1_b.first->first, t1_b.second->first,
+                      t1_b.first->second.at(prop), t1_b.second->second.at(prop),
+                      t);
+    double param2 =
+        math::Linterp(t2_b.first->first, t2_b.second->first,
+                      t2_b.first->second.at(prop), t2_b.second->second.at(prop),
+                      t);
+    res[prop] =
+        math::Linterp(p_b.first->first, p_b.second->first, param1, param2, p);
+  }
+  return res;
+}
+
+void TestFuelGrid() {
+  base::Database base("ini_data");
+  const fuel::Fuel& fuel = base.GetFuel("nikag");
+  // The registry entry may be mapped from the binary file, which keeps no
+  // tables; the reference comes from the JSON.
+  std::ifstream fin(FileName("nikag", 'f'));
+  const fuel::Properties reference = fuel::Fuel(fin).GetProperties();
+  std::vector<std::pair<double, double>> states;
+  for (double p = 5E4; p < 1.2E7; p += 3.7E5) {
+    for (double t = 150.0; t < 4200.0; t += 13.3) {
+      states.emplace_back(p, t);
+    }
+  }
+  for (const auto& [p, t] : states) {
+    fuel::PropValues grid = fuel.GetProperties(p, t);
+    fuel::PropTable table = MapProperties(reference, p, t);
+    for (const auto& [prop, value] : table) {
+      assert(std::abs(grid[prop] - value) <= 1E-12 * std::abs(value) + 1E-300);
+    }
+    assert(fuel.GetProperty(p, t, fuel::FuelProp::k_eq) ==
+           grid[fuel::FuelProp::k_eq]);
+    fuel::PropValues masked =
+        fuel.GetProperties<fuel::FuelProp::v, fuel::FuelProp::z>(p, t);
+    assert(masked[fuel::FuelProp::v] == grid[fuel::FuelProp::v]);
+    assert(masked[fuel::FuelProp::z] == grid[fuel::FuelProp::z]);
+    assert(masked[fuel::FuelProp::mu] == 0.0);
+  }
+
+  using Clock = std::chrono::steady_clock;
+  double sum = 0.0;
+  auto start = Clock::now();
+  for (const auto& [p, t] : states) {
+    sum += MapProperties(reference, p, t).at(fuel::FuelProp::k_eq);
+  }
+  std::chrono::duration<double, std::milli> tables = Clock::now() - start;
+  double sum_grid = 0.0;
+  start = Clock::now();
+  for (const auto& [p, t] : states) {
+    sum_grid += fuel.GetProperties(p, t)[fuel::FuelProp::k_eq];
+  }
+  std::chrono::duration<double, std::milli> grid = Clock::now() - start;
+  assert(std::abs(sum - sum_grid) <= 1E-9 * std::abs(sum));
+  std::cout << "Fuel properties, " << states.size() << " states: tables "
+            << tables.count() << " ms, grid " << grid.count() << " ms"
+            << std::endl;
+  std::cout << "TestFuelGrid are OK" << std::endl;
+}
+
+// Round trip through the binary format: the mapped fuel must answer exactly as
+// the parsed one, and damaged files must be rejected.
+void TestFuelBinary() {
+  TestDir dir("fuel");
+  std::string json = dir.Path("nikag.json");
+  std::string bin = dir.Path("nikag.bin");
+  std::filesystem::copy_file(FileName("nikag", 'f'), json);
+  using Clock = std::chrono::steady_clock;
+  auto start = Clock::now();
+  std::ifstream fin(json);
+  fuel::Fuel parsed(fin);
+  std::chrono::duration<double, std::milli> parse = Clock::now() - start;
+  {
+    std::ofstream out(bin, std::ios::binary);
+    parsed.WriteBinary(out);
+  }
+  start = Clock::now();
+  fuel::Fuel mapped = fuel::Fuel::FromBinary(bin);
+  std::chrono::duration<double, std::milli> map = Clock::now() - start;
+
+  assert(mapped.GetTotalTemperatures() == parsed.GetTotalTemperatures());
+  for (double p = 5E4; p < 1.2E7; p += 3.7E5) {
+    assert(mapped.GetTotalTemp(p) == parsed.GetTotalTemp(p));
+    for (double t = 150.0; t < 4200.0; t += 13.3) {
+      assert(mapped.GetProperties(p, t) == parsed.GetProperties(p, t));
+    }
+  }
+  fuel::Fuel copy = mapped;
+  assert(copy.GetProperties(1E6, 2000.0) == parsed.GetProperties(1E6, 2000.0));
+  bool thrown = false;
+  try {
+    mapped.GetProperties();
+  } catch (const std::logic_error&) {
+    thrown = true;
+  }
+  assert(thrown);
+
+  std::string bytes;
+  {
+    std::ifstream in(bin, std::ios::binary);
+    bytes.assign(std::istreambuf_iterator<char>(in), {});
+  }
+  bytes[bytes.size() / 2] ^= 1;
+  {
+    std::ofstream out(bin, std::ios::binary);
+    out << bytes;
+  }
+  thrown = false;
+  try {
+    fuel::Fuel::FromBinary(bin);
+  } catch (const std::runtime_error&) {
+    thrown = true;
+  }
+  assert(thrown);
+
+  // A damaged cache newer than the JSON is rebuilt instead of failing.
+  fuel::Fuel rebuilt = fuel::Fuel::Load(json, bin);
+  assert(rebuilt.GetProperties(1E6, 2000.0) ==
+         parsed.GetProperties(1E6, 2000.0));
+  assert(fuel::Fuel::FromBinary(bin).Fingerprint() == parsed.Fingerprint());
+  std::cout << "Fuel load: JSON " << parse.count() << " ms, binary "
+            << map.count() << " ms" << std::endl;
+  std::cout << "TestFuelBinary are OK" << std::endl;
+}
@@ -1,4 +1,5 @@
 #include "ini_data.h"
+#include <cassert>
 #include <fstream>
 
 void TestCreateEmptyIni() {
@@ -8,4 +9,24 @@ void TestCreateEmptyIni() {
 }
 void TestParse() {
   IniData ini_data("ini_data");
+}
+
+void TestHeatTable() {
+  IniData::HeatTransfer heat;
+  heat.alpha = {{300.0, 1000.0}, {1500.0, 4000.0}, {2500.0, 9000.0}};
+  heat.te = {{0.0, 2300.0}};
+  heat.trad = {{500.0, 2000.0}, {2000.0, 2600.0}};
+  heat.eps = {{400.0, 0.3}, {1200.0, 0.5}, {1800.0, 0.7}, {3000.0, 0.8}};
+  heat.q = {{1000.0, 0.0}, {2000.0, 1E5}};
+  heat.Compile();
+  math::SegmentCursor cursor;
+  for (double t = 0.0; t < 3500.0; t += 0.37) {
+    IniData::HeatValues v = heat(t, cursor);
+    assert(std::abs(v.alpha - math::Linterp(heat.alpha, t)) < 1E-9);
+    assert(std::abs(v.te - math::Linterp(heat.te, t)) < 1E-9);
+    assert(std::abs(v.trad - math::Linterp(heat.trad, t)) < 1E-9);
+    assert(std::abs(v.eps - math::Linterp(heat.eps, t)) < 1E-12);
+    assert(std::abs(v.q - math::Linterp(heat.q, t)) < 1E-7);
+  }
+  std::cout << "TestHeatTable are OK" << std::endl;
 }
\ No newline at end of file
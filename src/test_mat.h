@@ -1,6 +1,9 @@
 #pragma once
 #include <cassert>
+#include <chrono>
 #include <cmath>
+#include <cstdio>
+#include <filesystem>
 
 #include "common.h"
 #include "material.h"
@@ -38,4 +41,116 @@ void TestGetProperty() {
   std::cout << "TestGetProperty are OK" << std::endl;
 }
 
+void TestGrid() {
+  Material table("yt3", 60.0, 0.0);
+  for (double step : {1.0, 7.0, 0.3}) {
+    Material mat("yt3", 60.0, step);
+    for (Property prop : {Property::ro, Property::l, Property::cp, Property::ko}) {
+      Thermal props = table.GetProps();
+      for (const auto& [t, value] : props.at(prop)) {
+        assert(std::abs(mat.GetProperty(t, prop) - value) <= 1E-12 * std::abs(value));
+      }
+      for (double t = 200.0; t < 4100.0; t += 0.37) {
+        double exact = table.GetProperty(t, prop);
+        assert(std::abs(mat.GetProperty(t, prop) - exact) <= 1E-12 * std::abs(exact));
+      }
+    }
+  }
+  Material mat("yt3", 60.0, 1.0);
+  mat.PrintGridReport(std::cout);
+  std::cout << "TestGrid are OK" << std::endl;
+}
+
+void TestExactIntegration() {
+  Material mat("yt3", 60.0);
+  const size_t n = 200000;
+  std::vector<std::pair<double, double>> bounds{
+      {250.0, 3400.0}, {100.0, 5000.0}, {900.0, 900.0 + 1E-7},
+      {1195.0, 1205.0}, {1500.0, 700.0}, {4100.0, 4200.0}};
+  for (const auto& [a, b] : bounds) {
+    double mean = 0.0;
+    double inverse = 0.0;
+    for (size_t k = 0; k < n; ++k) {
+      double t = a + (b - a) * (k + 0.5) / n;
+      mean += mat.GetProperty(t, Property::cp) / n;
+      inverse += 1.0 / mat.GetProperty(t, Property::l) / n;
+    }
+    assert(std::abs(mat.MeanProperty(a, b, Property::cp) - mean) < 1E-6 * mean);
+    assert(std::abs(mat.HarmonicMeanProperty(a, b, Property::l) - 1.0 / inverse) <
+           1E-6 / inverse);
+    assert(mat.MeanProperty(a, b, Property::cp) ==
+           mat.MeanProperty(b, a, Property::cp));
+  }
+  assert(std::abs(mat.MeanProperty(900.0, 900.0, Property::cp) -
+                  mat.GetProperty(900.0, Property::cp)) < EPS);
+  assert(std::abs(mat.MeanProperty(300.0, 3000.0, Property::ro) - 600.0) < EPS);
+  std::cout << "TestExactIntegration are OK" << std::endl;
+}
+
+void TestBatchProperty() {
+  std::vector<double> ta;
+  std::vector<double> tb;
+  for (double t = 100.0; t < 4500.0; t += 0.731) {
+    ta.push_back(t);
+    tb.push_back(t * 0.97 + 40.0);
+  }
+  std::vector<double> out(ta.size());
+  for (double step : {0.0, 1.0}) {
+    Material mat("yt3", 60.0, step);
+    for (Property prop : {Property::ro, Property::l, Property::cp}) {
+      mat.GetProperty(ta, prop, out);
+      for (size_t k = 0; k < ta.size(); ++k) {
+        double value = mat.GetProperty(ta[k], prop);
+        assert(std::abs(out[k] - value) <= 1E-12 * std::abs(value));
+      }
+      mat.MeanProperty(ta, tb, prop, out);
+      for (size_t k = 0; k < ta.size(); ++k) {
+        assert(out[k] == mat.MeanProperty(ta[k], tb[k], prop));
+      }
+      mat.HarmonicMeanProperty(ta, tb, prop, out);
+      for (size_t k = 0; k < ta.size(); ++k) {
+        assert(out[k] == mat.HarmonicMeanProperty(ta[k], tb[k], prop));
+      }
+    }
+  }
+  std::cout << "TestBatchProperty are OK" << std::endl;
+}
+
+// The second construction maps the cache written by the first; touching the
+// JSON entry must invalidate it.
+void TestMaterialCache() {
+  using Clock = std::chrono::steady_clock;
+  std::string bin = FileName("yt3", 'M');
+  std::remove(bin.c_str());
+  auto start = Clock::now();
+  Material parsed("yt3", 60.0, 0.0);
+  std::chrono::duration<double, std::milli> parse = Clock::now() - start;
+  assert(std::filesystem::exists(bin));
+  start = Clock::now();
+  Material cached("yt3", 60.0, 0.0);
+  std::chrono::duration<double, std::milli> map = Clock::now() - start;
+  assert(cached.GetName() == parsed.GetName());
+  assert(cached.GetProps() == parsed.GetProps());
+  for (double t = 100.0; t < 4500.0; t += 0.731) {
+    assert(cached.MeanProperty(t, t + 50.0, Property::l) ==
+           parsed.MeanProperty(t, t + 50.0, Property::l));
+  }
+  Material angle("yt3", 30.0, 0.0);
+  std::ifstream fin(FileName("yt3", 'm'));
+  Material reference(fin, 30.0, 0.0);
+  assert(angle.GetProps() == reference.GetProps());
+
+  auto stamp = std::filesystem::last_write_time(bin);
+  std::filesystem::last_write_time(
+      FileName("yt3", 'm'),
+      std::filesystem::last_write_time(FileName("yt3", 'm')) +
+          std::chrono::seconds(1));
+  Material rebuilt("yt3", 60.0, 0.0);
+  assert(std::filesystem::last_write_time(bin) != stamp);
+  assert(rebuilt.GetProps() == parsed.GetProps());
+  std::cout << "Material load: JSON " << parse.count() << " ms, cache "
+            << map.count() << " ms" << std::endl;
+  std::cout << "TestMaterialCache are OK" << std::endl;
+}
+
 }  // namespace material
\ No newline at end of file
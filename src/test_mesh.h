@@ -1,6 +1,7 @@
 #pragma once
 
-#include <execution>
+#include <cassert>
+#include <thread>
 
 #include "data_base.h"
 #include "log_duration.h"
@@ -8,31 +9,34 @@
 
 void TestMesh() {
   IniData ini("ini_data");
-  base::Database database("ini_data");
+  base::Database database(ini);
   Mesh mesh(database, ini);
   mesh.UpdateVolumeProps();
   mesh.PrintGeomDebug(std::cout);
   mesh.PrintThermDebug(std::cout);
 }
 
-// void TestLeff() {
-//   IniData ini("ini_data");
-//   base::Database database("ini_data");
-//   Mesh mesh(database, ini);
-//   int n = 100;
-//   {
-//     LOG_DURATION("Sequence");
-//     for (int i = 0; i < n; ++i)
-//       std::for_each(std::execution::seq, mesh.GetVolumes().begin(),
-//                     mesh.GetVolumes().end(),
-//                     [&](Volume& vol) { vol.CalcProps(); });
-//   }
-//   {
-//     LOG_DURATION("Parallel");
-//     for (int i = 0; i < n; ++i)
-//       std::for_each(std::execution::par, mesh.GetVolumes().begin(),
-//                     mesh.GetVolumes().end(),
-//                     [&](Volume& vol) { vol.CalcProps(); });
-//   }
-//   // mesh.PrintLeff();
-// }
\ No newline at end of file
+void TestLeff() {
+  IniData ini("ini_data");
+  base::Database database(ini);
+  Mesh mesh(database, ini);
+  int n = 100;
+  mesh.SetThreads(1);
+  mesh.UpdateVolumeProps();
+  std::vector<double> l_eff(mesh.LEffLeft().begin(), mesh.LEffLeft().end());
+  size_t max_threads = std::max(1u, std::thread::hardware_concurrency());
+  for (size_t threads = 1; threads <= max_threads; threads *= 2) {
+    mesh.SetThreads(threads);
+    LogDuration dur("Volume props, threads = " + std::to_string(threads));
+    dur.Start();
+    for (int i = 0; i < n; ++i) {
+      // The temperatures do not change, so without this every call after the
+      // first would reuse all the faces.
+      mesh.InvalidateProps();
+      mesh.UpdateVolumeProps();
+      assert(mesh.SkippedVolumes() == 0);
+    }
+    dur.Stop();
+    assert(std::equal(l_eff.begin(), l_eff.end(), mesh.LEffLeft().begin()));
+  }
+}
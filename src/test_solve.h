@@ -1,27 +1,216 @@
 #pragma once
 
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <set>
+
+#include "boundary_cond.h"
+#include "boundary_gen.h"
 #include "ini_data.h"
 #include "logger.h"
 #include "mesh.h"
 #include "solver.h"
+#include "test_case.h"
 
 extern Logger logger;
 extern LogDuration dur_solver;
 
 void TestSolver() {
-  std::stringstream ss;
   IniData ini("ini_data");
-  base::Database base("ini_data");
+  base::Database base(ini);
   Mesh mesh(base, ini);
   logger.Domain(ini.GetDomainSettings());
   logger.InitialState(ini.GetInitialState());
+  heat_exchange::PrepareBoundary(
+      ini, base.GetFuel(ini.GetDomainSettings().fuel_name));
   Results res;
   MainSolve solver(mesh, ini, res, logger);
+  auto writer = std::make_shared<ResultsWriter>("res.txt");
+  solver.StreamResults(writer);
   dur_solver.Start();
   solver.solve_impl();
   dur_solver.Stop();
-  res.PrintBoundsDistr(ss, ini);
-  res.PrintXDistr(ss);
-  std::ofstream out("res.txt");
-  out << ss.str();
-}
\ No newline at end of file
+  writer->Close();
+}
+
+// Snapshots streamed through a ring of a few rows, so that the solver has to
+// wait for the writer, must give the same file as the rows kept in memory.
+void TestResultsWriter() {
+  TestDir dir("writer");
+  TestRun run(dir, "ini_data");
+  TestRun stream(dir, "ini_stream");
+  run.Solve();
+  // The rows reserved are the rows of the run, as counted from the schedule.
+  assert(run.res.Rows() == run.res.time.capacity());
+  std::stringstream ss;
+  run.res.PrintBoundsDistr(ss, run.ini);
+  run.res.PrintXDistr(ss);
+
+  std::string filename = dir.Path("res_stream.txt");
+  auto writer = std::make_shared<ResultsWriter>(filename, 2);
+  MainSolve solver(stream.mesh, stream.ini, stream.res, stream.log);
+  assert(stream.res.time.capacity() == 0 && stream.res.temp.capacity() == 0);
+  solver.StreamResults(writer);
+  solver.solve_impl();
+  writer->Close();
+  assert(writer->Rows() == run.res.Rows());
+  assert(stream.res.Rows() == 0 && stream.res.temp.capacity() == 0);
+  std::ifstream fin(filename);
+  std::stringstream streamed;
+  streamed << fin.rdbuf();
+  assert(streamed.str() == ss.str());
+  assert(!std::filesystem::exists(filename + ".x"));
+  std::cout << "Results writer: " << writer->Rows() << " rows, "
+            << writer->Stalls() << " waited for a free row" << std::endl;
+  std::cout << "TestResultsWriter are OK" << std::endl;
+}
+
+// The grid errors go to the case log unless disabled, and never without a
+// grid.
+void TestGridReport() {
+  TestDir dir("grid_report");
+  for (const auto& [name, patch] :
+       std::vector<std::pair<std::string, ordered_json>>{
+           {"ini_report", ordered_json::object()},
+           {"ini_no_report", {{"material grid report", false}}},
+           {"ini_no_grid", {{"material grid step", 0.0}}}}) {
+    {
+      TestRun run(dir, name, patch);
+      MainSolve(run.mesh, run.ini, run.res, run.log);
+    }
+    std::ifstream fin(dir.Path("LOG_" + name + ".txt"));
+    std::stringstream log;
+    log << fin.rdbuf();
+    // One table per layer material and angle.
+    IniData ini(dir.Path(name));
+    const IniData::Domain& domain = ini.GetDomainSettings();
+    std::set<std::pair<std::string, double>> layers;
+    for (size_t i = 0; i < domain.mat_names.size(); ++i) {
+      layers.emplace(domain.mat_names[i], domain.angles[i]);
+    }
+    size_t tables = 0;
+    for (size_t pos = log.str().find("Material: "); pos != std::string::npos;
+         pos = log.str().find("Material: ", pos + 1)) {
+      ++tables;
+    }
+    assert(tables == (name == "ini_report" ? layers.size() : 0));
+  }
+  std::cout << "TestGridReport are OK" << std::endl;
+}
+
+void TestPropsTolerance() {
+  TestDir dir("props");
+  TestRun reference(dir, "ini_data");
+  TestRun props(dir, "ini_props", {{"props tolerance", 0.1}});
+  reference.Solve();
+  props.Solve();
+  assert(props.mesh.SkippedVolumes() > 0);
+  for (size_t i = 0; i < reference.mesh.Size(); ++i) {
+    assert(std::abs(reference.mesh.TCurr()[i] - props.mesh.TCurr()[i]) < 1.0);
+  }
+  std::cout << "TestPropsTolerance are OK, skipped "
+            << props.mesh.SkippedVolumes() << " of " << reference.mesh.Size()
+            << std::endl;
+}
+
+
+// A time schedule must give the same run whether it is sampled at once or
+// streamed in chunks, and must match the tables at the step times.
+void TestBoundarySchedule() {
+  TestDir dir("schedule");
+  ordered_json patch = {
+      {"boundary time schedule", true},
+      {"boundary left",
+       {{"alpha",
+         {{0.0, 10.0, 30.0, 60.0}, {8000.0, 6000.0, 9000.0, 2000.0}}},
+        {"te", {{0.0, 20.0, 60.0}, {2300.0, 2800.0, 1500.0}}}}}};
+  TestRun run(dir, "ini_schedule", patch);
+  patch["schedule chunk"] = 7;
+  TestRun chunk(dir, "ini_schedule_chunk", patch);
+  const IniData& ini = run.ini;
+
+  BoundarySchedule schedule(chunk.ini);
+  for (size_t step = 1; step <= schedule.Steps(); ++step) {
+    schedule.Seek(step);
+    double time = step * ini.GetSolverSettings().solve_timestep;
+    const IniData::HeatTransfer& heat = ini.GetBoundaryTable().heat_left;
+    assert(std::abs(schedule.Left(step).alpha -
+                    math::Linterp(heat.alpha, time)) < 1E-9);
+    assert(std::abs(schedule.Left(step).te - math::Linterp(heat.te, time)) <
+           1E-9);
+  }
+
+  run.Solve();
+  chunk.Solve();
+  for (size_t i = 0; i < run.mesh.Size(); ++i) {
+    assert(run.mesh.TCurr()[i] == chunk.mesh.TCurr()[i]);
+  }
+  std::cout << "TestBoundarySchedule are OK" << std::endl;
+}
+// Left tables generated from the pressure history: the parallel stage must
+// match a serial evaluation, the second call must come from the disk cache,
+// and the solver must run on the result with the right wall still read at
+// the wall temperature.
+void TestBoundaryGenerator() {
+  TestDir dir("generate");
+  TestRun run(dir, "ini_generate",
+              {{"generate boundary", true}, {"initial radius", 0.5}});
+  const IniData& ini = run.ini;
+  const fuel::Fuel& fuel = run.base.GetFuel(ini.GetDomainSettings().fuel_name);
+
+  using Clock = std::chrono::steady_clock;
+  auto start = Clock::now();
+  IniData::HeatTransfer heat =
+      heat_exchange::GenerateHeatLeft(ini, fuel, dir.Path("boundaries"));
+  std::chrono::duration<double, std::milli> cold = Clock::now() - start;
+  start = Clock::now();
+  IniData::HeatTransfer cached =
+      heat_exchange::GenerateHeatLeft(ini, fuel, dir.Path("boundaries"));
+  std::chrono::duration<double, std::milli> warm = Clock::now() - start;
+  assert(cached.alpha == heat.alpha && cached.te == heat.te &&
+         cached.trad == heat.trad && cached.eps == heat.eps);
+  assert(ini.GetBoundaryTable().heat_left.alpha == heat.alpha);
+
+  flow::Flow1D flow(fuel);
+  heat_exchange::HeatExchange exchange(fuel, flow);
+  const IniData::Domain& domain = ini.GetDomainSettings();
+  for (const auto& [time, alpha] : heat.alpha) {
+    double p = math::Linterp(*ini.GetInitialState().pressure, time);
+    heat_exchange::Result r = exchange.Calc(
+        heat_exchange::IniDataAvd{p, domain.throat_radius.value(),
+                                  domain.initial_radius.value(),
+                                  domain.blayer_length.value(),
+                                  ini.GetBoundaryTable().flow_type},
+        heat_exchange::CalcType::avd);
+    assert(std::abs(r.alfa - alpha) <= 1E-9 * alpha);
+    assert(std::abs(r.t_e - heat.te.at(time)) <= 1E-9 * r.t_e);
+  }
+
+  assert(ini.GetSolverSettings().time_schedule_left);
+  assert(!ini.GetSolverSettings().time_schedule_right);
+  MainSolve solver(run.mesh, ini, run.res, run.log);
+  const IniData::HeatTransfer& right = ini.GetBoundaryTable().heat_right;
+  for (double t_wall : {300.0, 900.0, 2500.0}) {
+    assert(solver.RightHeat(t_wall).alpha ==
+           math::Linterp(right.alpha, t_wall));
+  }
+  solver.solve_impl();
+  for (double t : run.mesh.TCurr()) {
+    assert(std::isfinite(t));
+  }
+
+  IniData unprepared(dir.Path("ini_generate"));
+  bool thrown = false;
+  try {
+    MainSolve(run.mesh, unprepared, run.res, run.log);
+  } catch (const std::logic_error&) {
+    thrown = true;
+  }
+  assert(thrown);
+  std::cout << "Boundary tables, " << heat.alpha.size() << " steps: generated "
+            << cold.count() << " ms, cached " << warm.count() << " ms"
+            << std::endl;
+  std::cout << "TestBoundaryGenerator are OK" << std::endl;
+}
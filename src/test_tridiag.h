@@ -0,0 +1,62 @@
+#pragma once
+#include <cassert>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <thread>
+
+#include "log_duration.h"
+#include "thread_pool.h"
+#include "tridiag.h"
+
+void TestTridiagScaling() {
+  size_t n = 1000000;
+  int repeats = 20;
+  std::mt19937 gen(42);
+  std::uniform_real_distribution<double> dist(0.1, 1.0);
+  std::vector<double> a(n), b(n), c(n), d(n), x(n), x_ref(n), work(n);
+  for (size_t i = 0; i < n; ++i) {
+    a[i] = -dist(gen);
+    c[i] = -dist(gen);
+    b[i] = 2.0 + dist(gen);
+    d[i] = 300.0 * dist(gen);
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  for (int r = 0; r < repeats; ++r) {
+    tridiag::Thomas(a, b, c, d, x_ref, work);
+  }
+  std::chrono::duration<double, std::milli> seq =
+      std::chrono::steady_clock::now() - start;
+  std::cout << "Thomas, n = " << n << ": " << seq.count() / repeats << " ms"
+            << std::endl;
+
+  size_t max_threads = std::max(1u, std::thread::hardware_concurrency());
+  for (size_t threads = 1; threads <= max_threads; threads *= 2) {
+    ThreadPool pool(threads);
+    tridiag::Partitioned solver(pool);
+    start = std::chrono::steady_clock::now();
+    for (int r = 0; r < repeats; ++r) {
+      solver.Solve(a, b, c, d, x);
+    }
+    std::chrono::duration<double, std::milli> par =
+        std::chrono::steady_clock::now() - start;
+    double diff = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+      diff = std::max(diff, std::abs(x[i] - x_ref[i]) / std::abs(x_ref[i]));
+    }
+    assert(diff < 1E-12);
+    std::cout << "Partitioned, threads = " << threads << ": "
+              << par.count() / repeats << " ms, speedup "
+              << seq.count() / par.count() << std::endl;
+  }
+
+  // Forces the partitioned path on a single thread count above one.
+  ThreadPool pool(4);
+  tridiag::Partitioned solver(pool);
+  solver.Solve(a, b, c, d, x);
+  for (size_t i = 0; i < n; ++i) {
+    assert(std::abs(x[i] - x_ref[i]) <= 1E-12 * std::abs(x_ref[i]));
+  }
+  std::cout << "TestTridiagScaling are OK" << std::endl;
+}
@@ -1,8 +1,13 @@
 #include "logger.h"
+#include "test_batch.h"
+#include "test_cursor.h"
+#include "test_flow.h"
+#include "test_fuel.h"
 #include "test_inidata.h"
 #include "test_mat.h"
 #include "test_mesh.h"
 #include "test_solve.h"
+#include "test_tridiag.h"
 
 Logger logger("LOG.txt", 1);
 LogDuration dur_res_write("Results write");
@@ -15,9 +20,29 @@ LogDuration dur_t_calc("T calc");
 int main() {
   // material::TestOpen();
   // material::TestGetProperty();
+  // material::TestGrid();
+  // material::TestExactIntegration();
+  // material::TestBatchProperty();
+  // material::TestMaterialCache();
   // TestCreateEmptyIni();
   // TestParse();
+  // TestHeatTable();
   // TestMesh();
   // TestLeff();
+  // TestBatchSolver();
+  // TestSharedDatabase();
+  // TestStations();
+  // TestStationError();
+  // TestTridiagScaling();
+  // TestGridReport();
+  // TestPropsTolerance();
+  // TestResultsWriter();
+  // TestLinterpCursor();
+  // TestBoundarySchedule();
+  // TestBoundaryGenerator();
+  // TestFuelGrid();
+  // TestFuelBinary();
+  // TestLambdaSolver();
+  // TestHeatExchangeBatch();
   TestSolver();
 }
\ No newline at end of file
@@ -0,0 +1,119 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Fixed set of worker threads reused across calls. ParallelFor hands out task
+// indices to the workers and to the calling thread and returns when all of
+// them are done. A task that throws does not stop the others; the first
+// exception is rethrown on the calling thread once every task has run.
+class ThreadPool {
+ private:
+  std::vector<std::thread> workers_;
+  std::mutex mutex_;
+  std::condition_variable start_;
+  std::condition_variable done_;
+  const std::function<void(size_t)>* task_ = nullptr;
+  size_t count_ = 0;
+  std::atomic<size_t> next_ = 0;
+  size_t busy_ = 0;
+  size_t generation_ = 0;
+  bool stop_ = false;
+  std::exception_ptr error_;
+
+  void RunTask(const std::function<void(size_t)>& task, size_t i) {
+    try {
+      task(i);
+    } catch (...) {
+      std::lock_guard lock(mutex_);
+      if (!error_) {
+        error_ = std::current_exception();
+      }
+    }
+  }
+
+  // Called once the workers are idle, so error_ needs no lock.
+  void Rethrow() {
+    if (error_) {
+      std::rethrow_exception(std::exchange(error_, nullptr));
+    }
+  }
+
+  void RunTasks() {
+    for (size_t i = next_++; i < count_; i = next_++) {
+      RunTask(*task_, i);
+    }
+  }
+
+  void Work() {
+    size_t seen = 0;
+    while (true) {
+      {
+        std::unique_lock lock(mutex_);
+        start_.wait(lock, [&] { return stop_ || generation_ != seen; });
+        if (stop_) {
+          return;
+        }
+        seen = generation_;
+      }
+      RunTasks();
+      std::lock_guard lock(mutex_);
+      if (--busy_ == 0) {
+        done_.notify_one();
+      }
+    }
+  }
+
+ public:
+  explicit ThreadPool(size_t threads) {
+    for (size_t i = 1; i < threads; ++i) {
+      workers_.emplace_back([this] { Work(); });
+    }
+  }
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  ~ThreadPool() {
+    {
+      std::lock_guard lock(mutex_);
+      stop_ = true;
+    }
+    start_.notify_all();
+    for (std::thread& worker : workers_) {
+      worker.join();
+    }
+  }
+
+  size_t Size() const { return workers_.size() + 1; }
+
+  void ParallelFor(size_t count, const std::function<void(size_t)>& task) {
+    if (workers_.empty() || count <= 1) {
+      for (size_t i = 0; i < count; ++i) {
+        RunTask(task, i);
+      }
+      Rethrow();
+      return;
+    }
+    {
+      std::lock_guard lock(mutex_);
+      task_ = &task;
+      count_ = count;
+      next_ = 0;
+      busy_ = workers_.size();
+      ++generation_;
+    }
+    start_.notify_all();
+    RunTasks();
+    {
+      std::unique_lock lock(mutex_);
+      done_.wait(lock, [&] { return busy_ == 0; });
+    }
+    Rethrow();
+  }
+};
@@ -0,0 +1,106 @@
+#include "tridiag.h"
+
+namespace tridiag {
+
+void Thomas(std::span<const double> a, std::span<const double> b,
+            std::span<const double> c, std::span<const double> d,
+            std::span<double> x, std::span<double> work) {
+  size_t n = b.size();
+  work[0] = c[0] / b[0];
+  x[0] = d[0] / b[0];
+  for (size_t i = 1; i < n; ++i) {
+    double den = b[i] - a[i] * work[i - 1];
+    work[i] = c[i] / den;
+    x[i] = (d[i] - a[i] * x[i - 1]) / den;
+  }
+  for (size_t i = n - 1; i-- > 0;) {
+    x[i] -= work[i] * x[i + 1];
+  }
+}
+
+// After the reduction row i of chunk [s, e] reads
+// a_[i] x[s] + x[i] + c_[i] x[e] = d_[i] for s < i < e, while the first and
+// last rows couple to the neighbouring chunks:
+// a_[s] x[s - 1] + x[s] + c_[s] x[e] = d_[s],
+// a_[e] x[s] + x[e] + c_[e] x[e + 1] = d_[e].
+void Partitioned::Reduce(size_t k, std::span<const double> a,
+                         std::span<const double> b, std::span<const double> c,
+                         std::span<const double> d) {
+  size_t s = bounds_[k];
+  size_t e = bounds_[k + 1] - 1;
+  size_t n = b.size();
+  a_[s] = s == 0 ? 0.0 : a[s] / b[s];
+  c_[s] = c[s] / b[s];
+  d_[s] = d[s] / b[s];
+  a_[s + 1] = a[s + 1] / b[s + 1];
+  c_[s + 1] = (s + 1 == n - 1 ? 0.0 : c[s + 1]) / b[s + 1];
+  d_[s + 1] = d[s + 1] / b[s + 1];
+  for (size_t i = s + 2; i <= e; ++i) {
+    double r = 1.0 / (b[i] - a[i] * c_[i - 1]);
+    d_[i] = r * (d[i] - a[i] * d_[i - 1]);
+    c_[i] = r * (i == n - 1 ? 0.0 : c[i]);
+    a_[i] = -r * a[i] * a_[i - 1];
+  }
+  for (size_t i = e - 2; i > s; --i) {
+    d_[i] -= c_[i] * d_[i + 1];
+    a_[i] -= c_[i] * a_[i + 1];
+    c_[i] = -c_[i] * c_[i + 1];
+  }
+  double r = 1.0 / (1.0 - a_[s + 1] * c_[s]);
+  d_[s] = r * (d_[s] - c_[s] * d_[s + 1]);
+  a_[s] = r * a_[s];
+  c_[s] = -r * c_[s] * c_[s + 1];
+
+  ra_[2 * k] = a_[s];
+  rb_[2 * k] = 1.0;
+  rc_[2 * k] = c_[s];
+  rd_[2 * k] = d_[s];
+  ra_[2 * k + 1] = a_[e];
+  rb_[2 * k + 1] = 1.0;
+  rc_[2 * k + 1] = c_[e];
+  rd_[2 * k + 1] = d_[e];
+}
+
+void Partitioned::Fill(size_t k, std::span<double> x) const {
+  size_t s = bounds_[k];
+  size_t e = bounds_[k + 1] - 1;
+  x[s] = rx_[2 * k];
+  x[e] = rx_[2 * k + 1];
+  for (size_t i = s + 1; i < e; ++i) {
+    x[i] = d_[i] - a_[i] * x[s] - c_[i] * x[e];
+  }
+}
+
+void Partitioned::Solve(std::span<const double> a, std::span<const double> b,
+                        std::span<const double> c, std::span<const double> d,
+                        std::span<double> x) {
+  size_t n = b.size();
+  size_t chunks = Chunks();
+  if (chunks == 1 || n < 8 * chunks) {
+    work_.resize(n);
+    Thomas(a, b, c, d, x, work_);
+    return;
+  }
+  // Chunk bounds are multiples of 8 doubles, so threads do not share cache
+  // lines of the output.
+  bounds_.resize(chunks + 1);
+  for (size_t k = 0; k < chunks; ++k) {
+    bounds_[k] = n * k / chunks / 8 * 8;
+  }
+  bounds_[chunks] = n;
+  a_.resize(n);
+  c_.resize(n);
+  d_.resize(n);
+  ra_.resize(2 * chunks);
+  rb_.resize(2 * chunks);
+  rc_.resize(2 * chunks);
+  rd_.resize(2 * chunks);
+  rx_.resize(2 * chunks);
+  work_.resize(2 * chunks);
+
+  pool_.ParallelFor(chunks, [&](size_t k) { Reduce(k, a, b, c, d); });
+  Thomas(ra_, rb_, rc_, rd_, rx_, work_);
+  pool_.ParallelFor(chunks, [&](size_t k) { Fill(k, x); });
+}
+
+}  // namespace tridiag
@@ -0,0 +1,46 @@
+#pragma once
+#include <span>
+#include <vector>
+
+#include "thread_pool.h"
+
+// Tridiagonal systems a[i] x[i-1] + b[i] x[i] + c[i] x[i+1] = d[i];
+// a[0] and c[n-1] are ignored.
+namespace tridiag {
+
+void Thomas(std::span<const double> a, std::span<const double> b,
+            std::span<const double> c, std::span<const double> d,
+            std::span<double> x, std::span<double> work);
+
+// Partitioned Thomas algorithm: every thread reduces its chunk so that each
+// row depends only on the first and last row of the chunk, the 2P-row
+// interface system is solved sequentially, and the chunks are then filled in
+// parallel.
+class Partitioned {
+ private:
+  ThreadPool& pool_;
+  std::vector<size_t> bounds_;
+  std::vector<double> a_;
+  std::vector<double> c_;
+  std::vector<double> d_;
+  std::vector<double> ra_;
+  std::vector<double> rb_;
+  std::vector<double> rc_;
+  std::vector<double> rd_;
+  std::vector<double> rx_;
+  std::vector<double> work_;
+
+  void Reduce(size_t k, std::span<const double> a, std::span<const double> b,
+              std::span<const double> c, std::span<const double> d);
+  void Fill(size_t k, std::span<double> x) const;
+
+ public:
+  explicit Partitioned(ThreadPool& pool) : pool_(pool) {}
+  size_t Chunks() const { return pool_.Size(); }
+  ThreadPool& Pool() { return pool_; }
+  void Solve(std::span<const double> a, std::span<const double> b,
+             std::span<const double> c, std::span<const double> d,
+             std::span<double> x);
+};
+
+}  // namespace tridiag